@@ -0,0 +1,152 @@
+// Microbenchmarks for the C++ core, built as `flux_bench` when
+// FLUX_BUILD_BENCHMARKS=ON. CPU-only benchmarks (hashing, argv marshalling,
+// pool ring contention) always run; the RedisClient checkout and end-to-end
+// eval_sha benchmarks register only when a Redis answers on
+// FLUX_BENCH_REDIS_HOST/FLUX_BENCH_REDIS_PORT (default 127.0.0.1:6379), so the
+// suite stays runnable on build machines without a server.
+//
+// Run with --benchmark_repetitions / --benchmark_format=json to get results
+// comparable across commits (tools/compare.py from the benchmark repo).
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "eval_util.hpp"
+#include "mpmc_queue.hpp"
+#include "redis_client.hpp"
+#include "sha256.hpp"
+
+// ----------------------------------------------------------------------------
+// SHA-256 across key lengths
+// ----------------------------------------------------------------------------
+
+static void BM_Sha256(benchmark::State& state) {
+    std::string key(static_cast<size_t>(state.range(0)), 'k');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sha256(key));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_Sha256)->Arg(8)->Arg(32)->Arg(64)->Arg(256)->Arg(1024)->Arg(4096);
+
+static void BM_Sha256Key(benchmark::State& state) {
+    // The shape eval_script actually uses: prefix + hex digest, one allocation.
+    std::string key(static_cast<size_t>(state.range(0)), 'k');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sha256_key("flux:", key));
+    }
+}
+BENCHMARK(BM_Sha256Key)->Arg(16)->Arg(64)->Arg(256);
+
+// ----------------------------------------------------------------------------
+// EVALSHA argv marshalling
+// ----------------------------------------------------------------------------
+
+static void BM_BuildEvalshaArgv(benchmark::State& state) {
+    const std::string sha(40, 'a');
+    const std::vector<std::string> keys = {std::string(69, 'k')}; // prefix + hex digest
+    const std::vector<long long> args = {100, 60000, 1723650000000LL, 1};
+
+    for (auto _ : state) {
+        flux::EvalshaArgvBuilder argv(sha, keys, args);
+        benchmark::DoNotOptimize(argv.argv());
+        benchmark::DoNotOptimize(argv.argvlen());
+    }
+}
+BENCHMARK(BM_BuildEvalshaArgv);
+
+// ----------------------------------------------------------------------------
+// Pool ring contention (checkout/return without the network)
+// ----------------------------------------------------------------------------
+
+static void BM_PoolRingCheckout(benchmark::State& state) {
+    // Same MpmcQueue the connection pool uses, holding dummy pointers, so the
+    // number isolates ring contention from Redis latency.
+    static MpmcQueue<int*> ring(64);
+    static int slots[64];
+    if (state.thread_index() == 0) {
+        int* drain;
+        while (ring.try_pop(drain)) {}
+        for (int i = 0; i < 64; i++) ring.try_push(&slots[i]);
+    }
+
+    for (auto _ : state) {
+        int* ctx = nullptr;
+        while (!ring.try_pop(ctx)) {}
+        benchmark::DoNotOptimize(ctx);
+        ring.try_push(ctx);
+    }
+}
+BENCHMARK(BM_PoolRingCheckout)->ThreadRange(1, 64)->UseRealTime();
+
+// ----------------------------------------------------------------------------
+// Benchmarks that need a live Redis
+// ----------------------------------------------------------------------------
+
+namespace {
+
+std::unique_ptr<RedisClient> bench_client;
+std::string bench_script_sha;
+const char* kBenchScript = "return {0, 0, 0}";
+
+void BM_ConnectionGuard(benchmark::State& state) {
+    for (auto _ : state) {
+        RedisClient::ConnectionGuard guard(*bench_client);
+        benchmark::DoNotOptimize(guard.ctx);
+    }
+}
+
+void BM_EvalSha(benchmark::State& state) {
+    std::mt19937_64 rng(state.thread_index());
+    const std::vector<long long> args = {100, 60000};
+    for (auto _ : state) {
+        std::vector<std::string> keys = {sha256_key("flux:bench:", std::to_string(rng()))};
+        benchmark::DoNotOptimize(bench_client->eval_sha(bench_script_sha, keys, args));
+    }
+}
+
+bool try_register_redis_benchmarks() {
+    const char* host_env = std::getenv("FLUX_BENCH_REDIS_HOST");
+    const char* port_env = std::getenv("FLUX_BENCH_REDIS_PORT");
+    std::string host = host_env ? host_env : "127.0.0.1";
+    int port = port_env ? std::atoi(port_env) : 6379;
+
+    try {
+        bench_client = std::make_unique<RedisClient>(
+            host, port, /*pool_size=*/32, /*timeout_ms=*/200,
+            "flux_bench.log");
+        bench_script_sha = bench_client->load_script(kBenchScript);
+    } catch (const std::exception&) {
+        bench_client.reset();
+        return false;
+    }
+
+    benchmark::RegisterBenchmark("BM_ConnectionGuard", BM_ConnectionGuard)
+        ->ThreadRange(1, 64)->UseRealTime();
+    benchmark::RegisterBenchmark("BM_EvalSha", BM_EvalSha)
+        ->ThreadRange(1, 16)->UseRealTime();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!try_register_redis_benchmarks()) {
+        fprintf(stderr,
+                "flux_bench: no Redis reachable, skipping BM_ConnectionGuard/BM_EvalSha\n");
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    bench_client.reset();
+    return 0;
+}
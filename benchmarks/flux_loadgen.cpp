@@ -0,0 +1,295 @@
+// Standalone load generator for the _flux_core Redis path, built as
+// `flux_loadgen` when FLUX_BUILD_LOADGEN=ON. Unlike random_keys.lua (which
+// drives Redis directly), this goes through RedisClient::eval_script, so the
+// numbers include key hashing, argv marshalling, pool checkout and reply
+// parsing — the latency our callers actually see.
+//
+//   flux_loadgen --host 127.0.0.1 --port 6379 --threads 8 --rate 50000
+//                --duration 30 --keys 100000 --dist zipfian
+//
+// Latency is recorded in HDR-style histograms (logarithmic buckets with
+// linear sub-buckets, ~3% relative error) and measured from each request's
+// *scheduled* start time, so queueing delay under overload is not hidden
+// (no coordinated omission). Percentiles p50/p90/p99/p999 plus achieved
+// throughput are printed at the end; this is the acceptance gate for
+// performance work on the core.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "redis_client.hpp"
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// HDR-style histogram: 64 power-of-two buckets x 32 linear sub-buckets over
+// microseconds. Fixed footprint, lock-free recording, mergeable.
+// ----------------------------------------------------------------------------
+
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5; // 32 sub-buckets => <= ~3% error
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+
+    void record(uint64_t micros) {
+        counts[index_for(micros)]++;
+        total++;
+        if (micros > max_seen) max_seen = micros;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts.size(); i++) counts[i] += other.counts[i];
+        total += other.total;
+        if (other.max_seen > max_seen) max_seen = other.max_seen;
+    }
+
+    // Percentile in [0, 100]; returns the upper edge of the matching bucket.
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>((p / 100.0) * static_cast<double>(total));
+        if (rank >= total) rank = total - 1;
+
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            cumulative += counts[i];
+            if (cumulative > rank) return upper_edge(i);
+        }
+        return max_seen;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return max_seen; }
+
+private:
+    static size_t index_for(uint64_t v) {
+        if (v < kSubBuckets) return static_cast<size_t>(v);
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - kSubBucketBits;
+        size_t bucket = static_cast<size_t>(msb - kSubBucketBits + 1);
+        size_t sub = static_cast<size_t>((v >> shift) & (kSubBuckets - 1));
+        return bucket * kSubBuckets + sub;
+    }
+
+    static uint64_t upper_edge(size_t idx) {
+        size_t bucket = idx / kSubBuckets;
+        size_t sub = idx % kSubBuckets;
+        if (bucket == 0) return sub + 1;
+        int shift = static_cast<int>(bucket) - 1;
+        return (static_cast<uint64_t>(kSubBuckets + sub + 1)) << shift;
+    }
+
+    std::vector<uint64_t> counts = std::vector<uint64_t>(64 * kSubBuckets, 0);
+    uint64_t total = 0;
+    uint64_t max_seen = 0;
+};
+
+// ----------------------------------------------------------------------------
+// Key distributions
+// ----------------------------------------------------------------------------
+
+// YCSB-style constant-time zipfian generator (Gray et al.), so skewed tenant
+// traffic can be replayed without materializing a CDF over the whole keyspace.
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(uint64_t n, double theta, uint64_t seed)
+        : n(n), theta(theta), rng(seed) {
+        for (uint64_t i = 1; i <= n; i++) zetan += 1.0 / std::pow(static_cast<double>(i), theta);
+        zeta2 = 1.0 + std::pow(0.5, theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    }
+
+    uint64_t next() {
+        double u = uniform(rng);
+        double uz = u * zetan;
+        if (uz < 1.0) return 0;
+        if (uz < zeta2) return 1;
+        return static_cast<uint64_t>(
+            static_cast<double>(n) * std::pow(eta * u - eta + 1.0, alpha));
+    }
+
+private:
+    uint64_t n;
+    double theta;
+    double zetan = 0.0, zeta2 = 0.0, alpha = 0.0, eta = 0.0;
+    std::mt19937_64 rng;
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 6379;
+    std::string unix_socket;
+    int threads = 4;
+    int pool_size = 0;          // 0 => same as threads
+    double rate = 0;            // total req/s across threads; 0 => unthrottled
+    int duration_s = 10;
+    uint64_t keys = 100000;
+    std::string dist = "uniform";
+    double zipf_theta = 0.99;
+    std::string script_file;    // optional Lua file; default trivial script
+};
+
+bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto need = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "missing value for %s\n", name);
+                exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--host") opt.host = need("--host");
+        else if (arg == "--port") opt.port = std::atoi(need("--port"));
+        else if (arg == "--unix-socket") opt.unix_socket = need("--unix-socket");
+        else if (arg == "--threads") opt.threads = std::atoi(need("--threads"));
+        else if (arg == "--pool-size") opt.pool_size = std::atoi(need("--pool-size"));
+        else if (arg == "--rate") opt.rate = std::atof(need("--rate"));
+        else if (arg == "--duration") opt.duration_s = std::atoi(need("--duration"));
+        else if (arg == "--keys") opt.keys = std::strtoull(need("--keys"), nullptr, 10);
+        else if (arg == "--dist") opt.dist = need("--dist");
+        else if (arg == "--zipf-theta") opt.zipf_theta = std::atof(need("--zipf-theta"));
+        else if (arg == "--script-file") opt.script_file = need("--script-file");
+        else {
+            fprintf(stderr,
+                    "usage: flux_loadgen [--host H] [--port P] [--unix-socket PATH]\n"
+                    "                    [--threads N] [--pool-size N] [--rate R]\n"
+                    "                    [--duration S] [--keys K] [--dist uniform|zipfian]\n"
+                    "                    [--zipf-theta T] [--script-file F]\n");
+            return false;
+        }
+    }
+    if (opt.threads < 1) opt.threads = 1;
+    if (opt.pool_size <= 0) opt.pool_size = opt.threads;
+    if (opt.keys < 1) opt.keys = 1;
+    if (opt.dist != "uniform" && opt.dist != "zipfian") {
+        fprintf(stderr, "unknown distribution: %s\n", opt.dist.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) return 1;
+
+    std::string script = "return {0, 0, 0}";
+    if (!opt.script_file.empty()) {
+        std::ifstream in(opt.script_file);
+        if (!in) {
+            fprintf(stderr, "cannot read script file %s\n", opt.script_file.c_str());
+            return 1;
+        }
+        std::stringstream ss;
+        ss << in.rdbuf();
+        script = ss.str();
+    }
+
+    std::unique_ptr<RedisClient> client;
+    std::string sha;
+    try {
+        client = std::make_unique<RedisClient>(
+            opt.host, opt.port, static_cast<size_t>(opt.pool_size), 200,
+            "flux_loadgen.log", false,
+            /*enable_denial_cache=*/true, /*key_cache_size=*/10000,
+            /*shm_cache_name=*/"", opt.unix_socket);
+        sha = client->load_script(script);
+    } catch (const std::exception& e) {
+        fprintf(stderr, "setup failed: %s\n", e.what());
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::seconds(opt.duration_s);
+    const double per_thread_rate = opt.rate > 0 ? opt.rate / opt.threads : 0;
+
+    std::vector<LatencyHistogram> histograms(opt.threads);
+    std::atomic<uint64_t> errors{0};
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < opt.threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 rng(0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(t));
+            std::uniform_int_distribution<uint64_t> uniform_key(0, opt.keys - 1);
+            ZipfianGenerator zipf(opt.keys, opt.zipf_theta, rng());
+            const bool zipfian = (opt.dist == "zipfian");
+            const std::vector<long long> args = {100, 60000};
+
+            const auto interval = per_thread_rate > 0
+                ? std::chrono::nanoseconds(static_cast<int64_t>(1e9 / per_thread_rate))
+                : std::chrono::nanoseconds(0);
+            auto scheduled = Clock::now();
+
+            while (Clock::now() < deadline) {
+                if (interval.count() > 0) {
+                    std::this_thread::sleep_until(scheduled);
+                }
+
+                uint64_t id = zipfian ? zipf.next() : uniform_key(rng);
+                std::vector<std::string> keys = {"tenant:" + std::to_string(id)};
+
+                // Throttled runs measure from the *scheduled* start, so
+                // backlog under overload is charged to the request that
+                // suffered it; unthrottled runs measure pure service time.
+                auto issued = Clock::now();
+                auto measured_from = (interval.count() > 0 && scheduled < issued)
+                    ? scheduled : issued;
+
+                try {
+                    client->eval_script(sha, script, keys, args, "flux:loadgen:");
+                } catch (const std::exception&) {
+                    errors++;
+                }
+
+                auto now = Clock::now();
+                histograms[t].record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - measured_from).count()));
+
+                scheduled += interval;
+                if (scheduled < now - std::chrono::seconds(1)) {
+                    scheduled = now; // cap backlog at 1s so runs end on time
+                }
+            }
+        });
+    }
+
+    for (auto& w : workers) w.join();
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    LatencyHistogram merged;
+    for (const auto& h : histograms) merged.merge(h);
+
+    printf("threads=%d pool=%d dist=%s keys=%llu rate=%s duration=%.1fs\n",
+           opt.threads, opt.pool_size, opt.dist.c_str(),
+           static_cast<unsigned long long>(opt.keys),
+           opt.rate > 0 ? std::to_string(static_cast<long long>(opt.rate)).c_str() : "unthrottled",
+           elapsed);
+    printf("requests=%llu errors=%llu throughput=%.0f req/s\n",
+           static_cast<unsigned long long>(merged.count()),
+           static_cast<unsigned long long>(errors.load()),
+           static_cast<double>(merged.count()) / elapsed);
+    printf("latency (us): p50=%llu p90=%llu p99=%llu p999=%llu max=%llu\n",
+           static_cast<unsigned long long>(merged.percentile(50)),
+           static_cast<unsigned long long>(merged.percentile(90)),
+           static_cast<unsigned long long>(merged.percentile(99)),
+           static_cast<unsigned long long>(merged.percentile(99.9)),
+           static_cast<unsigned long long>(merged.max()));
+    return 0;
+}
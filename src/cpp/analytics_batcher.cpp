@@ -0,0 +1,164 @@
+#include "analytics_batcher.hpp"
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <vector>
+
+// ============================================================================
+// AnalyticsBatcher Implementation
+// ============================================================================
+
+namespace {
+// Flush cadence and batch bound: 20ms keeps the stream fresh enough for the
+// monitor while letting a busy process coalesce hundreds of XADDs per trip.
+constexpr int kFlushIntervalMs = 20;
+constexpr size_t kMaxBatch = 512;
+}
+
+AnalyticsBatcher::AnalyticsBatcher(const std::string& host, int port,
+                                   const std::string& unix_socket_path, int timeout_ms,
+                                   const std::string& stream_key, long long maxlen,
+                                   size_t ring_capacity)
+    : host(host), port(port), unix_socket_path(unix_socket_path), timeout_ms(timeout_ms),
+      stream_key(stream_key), maxlen_str(std::to_string(maxlen)),
+      ring(ring_capacity) {
+    flusher = std::thread(&AnalyticsBatcher::flush_loop, this);
+}
+
+AnalyticsBatcher::~AnalyticsBatcher() {
+    stop = true;
+    if (flusher.joinable()) flusher.join(); // performs a final drain
+
+    AnalyticsEvent* ev;
+    while (ring.try_pop(ev)) delete ev;
+    if (ctx) redisFree(ctx);
+}
+
+void AnalyticsBatcher::record(AnalyticsEvent&& event) {
+    auto* ev = new AnalyticsEvent(std::move(event));
+    while (!ring.try_push(ev)) {
+        // Drop-oldest: make room by discarding from the consumer end so the
+        // stream keeps the most recent picture of traffic.
+        AnalyticsEvent* oldest;
+        if (ring.try_pop(oldest)) {
+            delete oldest;
+            dropped_count++;
+        }
+    }
+}
+
+bool AnalyticsBatcher::ensure_connection() {
+    if (ctx && !ctx->err) return true;
+    if (ctx) {
+        redisFree(ctx);
+        ctx = nullptr;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    if (!unix_socket_path.empty()) {
+        ctx = redisConnectUnixWithTimeout(unix_socket_path.c_str(), timeout);
+    } else {
+        ctx = redisConnectWithTimeout(host.c_str(), port, timeout);
+    }
+
+    if (ctx == nullptr || ctx->err) {
+        if (ctx) {
+            redisFree(ctx);
+            ctx = nullptr;
+        }
+        return false;
+    }
+    return true;
+}
+
+// Pipelines one XADD per event; returns how many were handed to Redis. The
+// field names match what the Lua scripts used to write, so worker.py needs no
+// changes.
+size_t AnalyticsBatcher::flush_batch(AnalyticsEvent** events, size_t n) {
+    if (!ensure_connection()) return 0;
+
+    for (size_t i = 0; i < n; i++) {
+        const AnalyticsEvent& ev = *events[i];
+        std::string ts = std::to_string(ev.ts_ms);
+        std::string allowed = std::to_string(ev.allowed);
+        std::string usage = std::to_string(ev.usage);
+        std::string mr = std::to_string(ev.meta_requests);
+        std::string mp = std::to_string(ev.meta_period);
+        std::string mb = std::to_string(ev.meta_burst);
+
+        const char* argv[] = {
+            "XADD", stream_key.c_str(), "MAXLEN", "~", maxlen_str.c_str(), "*",
+            "ts", ts.c_str(),
+            "key", ev.key.c_str(),
+            "ep", ev.endpoint.c_str(),
+            "d", allowed.c_str(),
+            "p", ev.policy.c_str(),
+            "u", usage.c_str(),
+            "mr", mr.c_str(),
+            "mp", mp.c_str(),
+            "mb", mb.c_str(),
+        };
+        size_t argvlen[] = {
+            4, stream_key.size(), 6, 1, maxlen_str.size(), 1,
+            2, ts.size(),
+            3, ev.key.size(),
+            2, ev.endpoint.size(),
+            1, allowed.size(),
+            1, ev.policy.size(),
+            1, usage.size(),
+            2, mr.size(),
+            2, mp.size(),
+            2, mb.size(),
+        };
+
+        if (redisAppendCommandArgv(ctx, static_cast<int>(sizeof(argv) / sizeof(argv[0])),
+                                   argv, argvlen) != REDIS_OK) {
+            redisFree(ctx);
+            ctx = nullptr;
+            return 0;
+        }
+    }
+
+    // Drain every reply even on error so the connection stays in sync.
+    size_t delivered = 0;
+    for (size_t i = 0; i < n; i++) {
+        void* reply = nullptr;
+        if (redisGetReply(ctx, &reply) != REDIS_OK) {
+            redisFree(ctx);
+            ctx = nullptr;
+            break;
+        }
+        if (reply) {
+            if (((redisReply*)reply)->type != REDIS_REPLY_ERROR) delivered++;
+            freeReplyObject(reply);
+        }
+    }
+    return delivered;
+}
+
+void AnalyticsBatcher::flush_loop() {
+    AnalyticsEvent* batch[kMaxBatch];
+
+    while (true) {
+        size_t n = 0;
+        while (n < kMaxBatch && ring.try_pop(batch[n])) n++;
+
+        if (n > 0) {
+            size_t delivered = flush_batch(batch, n);
+            if (delivered < n) {
+                dropped_count += static_cast<long long>(n - delivered);
+                SPDLOG_DEBUG("analytics: flush delivered {}/{} events", delivered, n);
+            }
+            for (size_t i = 0; i < n; i++) delete batch[i];
+        }
+
+        if (stop && n == 0) break; // drained after shutdown was requested
+        if (n < kMaxBatch) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kFlushIntervalMs));
+        }
+        // A full batch means a backlog: loop again immediately.
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <hiredis.h>
+#include "mpmc_queue.hpp"
+
+// Off-request-path analytics recording.
+//
+// The Lua scripts used to XADD the analytics event inside the same invocation
+// as the rate-limit decision, doubling the work Redis does per check. Now the
+// decision path only enqueues the event into a bounded lock-free ring; a
+// background thread drains the ring and ships batched, pipelined XADDs
+// (hundreds per flush) to the stream worker.py consumes. Under backpressure
+// the oldest events are dropped — analytics are best-effort, enforcement
+// latency is not.
+struct AnalyticsEvent {
+    long long ts_ms;
+    std::string key;        // final (hashed) limit key, as the scripts logged
+    std::string endpoint;
+    int allowed;            // 1 allowed / 0 blocked
+    std::string policy;
+    long long usage;
+    long long meta_requests;
+    long long meta_period;
+    long long meta_burst;
+};
+
+class AnalyticsBatcher {
+public:
+    AnalyticsBatcher(const std::string& host, int port,
+                     const std::string& unix_socket_path, int timeout_ms,
+                     const std::string& stream_key, long long maxlen,
+                     size_t ring_capacity = 8192);
+    ~AnalyticsBatcher();
+
+    AnalyticsBatcher(const AnalyticsBatcher&) = delete;
+    AnalyticsBatcher& operator=(const AnalyticsBatcher&) = delete;
+
+    // Never blocks: on a full ring the oldest event is discarded.
+    void record(AnalyticsEvent&& event);
+
+    long long dropped() const { return dropped_count.load(); }
+
+private:
+    std::string host;
+    int port;
+    std::string unix_socket_path;
+    int timeout_ms;
+    std::string stream_key;
+    std::string maxlen_str;
+
+    MpmcQueue<AnalyticsEvent*> ring;
+    std::atomic<long long> dropped_count{0};
+    std::atomic<bool> stop{false};
+    std::thread flusher;
+
+    redisContext* ctx = nullptr; // owned by the flusher thread
+
+    void flush_loop();
+    bool ensure_connection();
+    size_t flush_batch(AnalyticsEvent** events, size_t n);
+};
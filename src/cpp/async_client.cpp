@@ -0,0 +1,399 @@
+#include "async_client.hpp"
+#include "sha256.hpp"
+#include <fmt/core.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <cerrno>
+
+// ============================================================================
+// AsyncRedisClient Implementation
+// ============================================================================
+
+AsyncRedisClient::AsyncRedisClient(std::string host, int port, size_t num_connections, int timeout_ms)
+    : host(host), port(port), timeout_ms(timeout_ms) {
+
+    if (num_connections == 0) num_connections = 1;
+
+    if (pipe(wake_pipe) != 0) {
+        throw std::runtime_error("AsyncRedisClient: failed to create wake pipe");
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+
+    connections.reserve(num_connections);
+    for (size_t i = 0; i < num_connections; i++) {
+        auto conn = std::make_unique<Connection>();
+        conn->parent = this;
+        connections.push_back(std::move(conn));
+    }
+
+    spdlog::debug("AsyncRedisClient: starting reactor with {} connection(s)", num_connections);
+    reactor = std::thread(&AsyncRedisClient::reactor_loop, this);
+}
+
+AsyncRedisClient::~AsyncRedisClient() {
+    stop_requested = true;
+    wake_reactor();
+    if (reactor.joinable()) reactor.join();
+
+    close(wake_pipe[0]);
+    close(wake_pipe[1]);
+
+    // Fail anything still parked in the submit queue.
+    std::lock_guard<std::mutex> lock(submit_mutex);
+    for (auto& cmd : submit_queue) {
+        auto err = std::make_exception_ptr(std::runtime_error("Client is shutting down"));
+        if (cmd->wants_string) cmd->str_promise.set_exception(err);
+        else cmd->int_promise.set_exception(err);
+    }
+    submit_queue.clear();
+}
+
+// ----------------------------------------------------------------------------
+// Submission (any thread)
+// ----------------------------------------------------------------------------
+
+void AsyncRedisClient::submit(std::unique_ptr<PendingCommand> cmd) {
+    {
+        std::lock_guard<std::mutex> lock(submit_mutex);
+        if (stop_requested) {
+            auto err = std::make_exception_ptr(std::runtime_error("Client is shutting down"));
+            if (cmd->wants_string) cmd->str_promise.set_exception(err);
+            else cmd->int_promise.set_exception(err);
+            return;
+        }
+        submit_queue.push_back(std::move(cmd));
+    }
+    wake_reactor();
+}
+
+void AsyncRedisClient::wake_reactor() {
+    char byte = 1;
+    // Non-blocking; if the pipe is full the reactor is already awake.
+    (void)!write(wake_pipe[1], &byte, 1);
+}
+
+std::future<std::string> AsyncRedisClient::submit_ping() {
+    auto cmd = std::make_unique<PendingCommand>();
+    cmd->wants_string = true;
+    cmd->argv = {"PING"};
+    auto future = cmd->str_promise.get_future();
+    submit(std::move(cmd));
+    return future;
+}
+
+std::future<std::string> AsyncRedisClient::submit_script_load(const std::string& script_content) {
+    auto cmd = std::make_unique<PendingCommand>();
+    cmd->wants_string = true;
+    cmd->argv = {"SCRIPT", "LOAD", script_content};
+    auto future = cmd->str_promise.get_future();
+    submit(std::move(cmd));
+    return future;
+}
+
+std::future<std::vector<long long>> AsyncRedisClient::submit_eval_sha(
+    const std::string& script_sha,
+    const std::vector<std::string>& keys,
+    const std::vector<long long>& args
+) {
+    auto cmd = std::make_unique<PendingCommand>();
+    cmd->argv.reserve(3 + keys.size() + args.size());
+    cmd->argv.push_back("EVALSHA");
+    cmd->argv.push_back(script_sha);
+    cmd->argv.push_back(std::to_string(keys.size()));
+    for (const auto& key : keys) cmd->argv.push_back(key);
+    for (long long arg : args) cmd->argv.push_back(std::to_string(arg));
+
+    auto future = cmd->int_promise.get_future();
+    submit(std::move(cmd));
+    return future;
+}
+
+// ----------------------------------------------------------------------------
+// Blocking conveniences
+// ----------------------------------------------------------------------------
+
+std::string AsyncRedisClient::ping() {
+    return submit_ping().get();
+}
+
+std::vector<long long> AsyncRedisClient::eval_script(
+    const std::string& script_sha,
+    const std::string& script_content,
+    const std::vector<std::string>& raw_keys,
+    const std::vector<long long>& args,
+    const std::string& key_prefix
+) {
+    // Hash keys inside C++, same as RedisClient::eval_script
+    std::vector<std::string> hashed_keys;
+    hashed_keys.reserve(raw_keys.size());
+    for (const auto& k : raw_keys) {
+        hashed_keys.push_back(sha256_key(key_prefix, k));
+    }
+
+    try {
+        return submit_eval_sha(script_sha, hashed_keys, args).get();
+    } catch (const std::runtime_error& e) {
+        std::string err = e.what();
+        if (err == "NOSCRIPT") {
+            spdlog::warn("NOSCRIPT received, re-loading script...");
+            submit_script_load(script_content).get();
+            return submit_eval_sha(script_sha, hashed_keys, args).get();
+        }
+        throw;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Reactor (dedicated thread)
+// ----------------------------------------------------------------------------
+
+bool AsyncRedisClient::connect_one(Connection& conn) {
+    redisAsyncContext* ctx = redisAsyncConnect(host.c_str(), port);
+    if (ctx == nullptr) return false;
+    if (ctx->err) {
+        spdlog::warn("AsyncRedisClient: connect failed: {}", ctx->errstr);
+        redisAsyncFree(ctx);
+        return false;
+    }
+
+    ctx->data = &conn;
+    ctx->ev.data = &conn;
+    ctx->ev.addRead = ev_add_read;
+    ctx->ev.delRead = ev_del_read;
+    ctx->ev.addWrite = ev_add_write;
+    ctx->ev.delWrite = ev_del_write;
+    ctx->ev.cleanup = ev_cleanup;
+
+    redisAsyncSetConnectCallback(ctx, on_connect);
+    redisAsyncSetDisconnectCallback(ctx, on_disconnect);
+
+    conn.ctx = ctx;
+    conn.connected = false;
+    return true;
+}
+
+AsyncRedisClient::Connection* AsyncRedisClient::pick_connection() {
+    // Round-robin over live contexts. hiredis buffers commands submitted
+    // before the connect handshake completes, so a pending (not yet
+    // connected) context is a valid target.
+    for (size_t i = 0; i < connections.size(); i++) {
+        Connection* conn = connections[next_connection].get();
+        next_connection = (next_connection + 1) % connections.size();
+        if (conn->ctx != nullptr) return conn;
+    }
+    return nullptr;
+}
+
+void AsyncRedisClient::drain_submit_queue() {
+    std::deque<std::unique_ptr<PendingCommand>> pending;
+    {
+        std::lock_guard<std::mutex> lock(submit_mutex);
+        pending.swap(submit_queue);
+    }
+
+    for (auto& cmd : pending) {
+        Connection* conn = pick_connection();
+        if (conn == nullptr) {
+            auto err = std::make_exception_ptr(
+                std::runtime_error("Redis command failed (no live connection)"));
+            if (cmd->wants_string) cmd->str_promise.set_exception(err);
+            else cmd->int_promise.set_exception(err);
+            continue;
+        }
+
+        std::vector<const char*> argv;
+        std::vector<size_t> argvlen;
+        argv.reserve(cmd->argv.size());
+        argvlen.reserve(cmd->argv.size());
+        for (const auto& part : cmd->argv) {
+            argv.push_back(part.c_str());
+            argvlen.push_back(part.size());
+        }
+
+        PendingCommand* raw = cmd.release();
+        if (redisAsyncCommandArgv(conn->ctx, on_reply, raw,
+                                  static_cast<int>(argv.size()),
+                                  argv.data(), argvlen.data()) != REDIS_OK) {
+            auto err = std::make_exception_ptr(
+                std::runtime_error("Redis command failed (Network error?)"));
+            if (raw->wants_string) raw->str_promise.set_exception(err);
+            else raw->int_promise.set_exception(err);
+            delete raw;
+        }
+    }
+}
+
+void AsyncRedisClient::reactor_loop() {
+    for (auto& conn : connections) {
+        connect_one(*conn);
+    }
+
+    std::vector<struct pollfd> fds;
+
+    while (!stop_requested) {
+        fds.clear();
+        fds.push_back({wake_pipe[0], POLLIN, 0});
+
+        for (auto& conn : connections) {
+            if (conn->ctx == nullptr) continue;
+            short events = 0;
+            if (conn->want_read) events |= POLLIN;
+            if (conn->want_write) events |= POLLOUT;
+            if (events == 0) continue;
+            fds.push_back({conn->ctx->c.fd, events, 0});
+        }
+
+        // A finite timeout doubles as the reconnect tick for dead contexts.
+        int ready = poll(fds.data(), static_cast<nfds_t>(fds.size()), 100);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            spdlog::error("AsyncRedisClient: poll failed: {}", strerror(errno));
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char buf[64];
+            while (read(wake_pipe[0], buf, sizeof(buf)) > 0) {}
+        }
+
+        // Match poll results back to contexts by fd; handlers may free the
+        // context mid-loop (disconnect), so re-check pointers each time.
+        for (size_t i = 1; i < fds.size(); i++) {
+            if (fds[i].revents == 0) continue;
+            for (auto& conn : connections) {
+                if (conn->ctx == nullptr || conn->ctx->c.fd != fds[i].fd) continue;
+                if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+                    redisAsyncHandleRead(conn->ctx);
+                }
+                if (conn->ctx != nullptr && (fds[i].revents & POLLOUT)) {
+                    redisAsyncHandleWrite(conn->ctx);
+                }
+                break;
+            }
+        }
+
+        for (auto& conn : connections) {
+            if (conn->ctx == nullptr) connect_one(*conn);
+        }
+
+        drain_submit_queue();
+    }
+
+    for (auto& conn : connections) {
+        if (conn->ctx != nullptr) {
+            redisAsyncFree(conn->ctx);
+            conn->ctx = nullptr;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// hiredis callbacks (reactor thread)
+// ----------------------------------------------------------------------------
+
+void AsyncRedisClient::ev_add_read(void* privdata) {
+    static_cast<Connection*>(privdata)->want_read = true;
+}
+
+void AsyncRedisClient::ev_del_read(void* privdata) {
+    static_cast<Connection*>(privdata)->want_read = false;
+}
+
+void AsyncRedisClient::ev_add_write(void* privdata) {
+    static_cast<Connection*>(privdata)->want_write = true;
+}
+
+void AsyncRedisClient::ev_del_write(void* privdata) {
+    static_cast<Connection*>(privdata)->want_write = false;
+}
+
+void AsyncRedisClient::ev_cleanup(void* privdata) {
+    Connection* conn = static_cast<Connection*>(privdata);
+    conn->want_read = false;
+    conn->want_write = false;
+}
+
+void AsyncRedisClient::on_connect(const redisAsyncContext* ctx, int status) {
+    Connection* conn = static_cast<Connection*>(ctx->data);
+    if (status == REDIS_OK) {
+        conn->connected = true;
+        spdlog::debug("AsyncRedisClient: connection established");
+    } else {
+        spdlog::warn("AsyncRedisClient: connect failed: {}", ctx->errstr ? ctx->errstr : "unknown");
+        conn->ctx = nullptr; // hiredis frees the context after this callback
+        conn->connected = false;
+    }
+}
+
+void AsyncRedisClient::on_disconnect(const redisAsyncContext* ctx, int status) {
+    Connection* conn = static_cast<Connection*>(ctx->data);
+    if (status != REDIS_OK) {
+        spdlog::warn("AsyncRedisClient: connection lost: {}", ctx->errstr ? ctx->errstr : "unknown");
+    }
+    conn->ctx = nullptr; // hiredis frees the context after this callback
+    conn->connected = false;
+}
+
+void AsyncRedisClient::on_reply(redisAsyncContext* ctx, void* reply_void, void* privdata) {
+    // hiredis owns the reply and frees it after this callback returns.
+    std::unique_ptr<PendingCommand> cmd(static_cast<PendingCommand*>(privdata));
+    redisReply* reply = static_cast<redisReply*>(reply_void);
+
+    auto fail = [&](const std::string& message) {
+        auto err = std::make_exception_ptr(std::runtime_error(message));
+        if (cmd->wants_string) cmd->str_promise.set_exception(err);
+        else cmd->int_promise.set_exception(err);
+    };
+
+    if (reply == nullptr) {
+        fail(ctx->errstr ? ctx->errstr : "Redis command failed (connection lost)");
+        return;
+    }
+
+    if (reply->type == REDIS_REPLY_ERROR) {
+        std::string error = reply->str;
+        if (error.find("NOSCRIPT") != std::string::npos) {
+            fail("NOSCRIPT");
+        } else {
+            fail("Lua error: " + error);
+        }
+        return;
+    }
+
+    if (cmd->wants_string) {
+        if (reply->type == REDIS_REPLY_STATUS || reply->type == REDIS_REPLY_STRING) {
+            cmd->str_promise.set_value(reply->str);
+        } else {
+            fail("Unexpected reply type");
+        }
+        return;
+    }
+
+    std::vector<long long> result;
+    if (reply->type == REDIS_REPLY_ARRAY) {
+        result.reserve(reply->elements);
+        for (size_t i = 0; i < reply->elements; i++) {
+            if (reply->element[i]->type == REDIS_REPLY_INTEGER) {
+                result.push_back(reply->element[i]->integer);
+            } else if (reply->element[i]->type == REDIS_REPLY_STRING) {
+                try {
+                    result.push_back(std::stoll(reply->element[i]->str));
+                } catch (...) {
+                    result.push_back(0);
+                }
+            } else {
+                result.push_back(0); // Fallback
+            }
+        }
+    } else if (reply->type == REDIS_REPLY_INTEGER) {
+        result.push_back(reply->integer);
+    } else {
+        fail("Unexpected reply type");
+        return;
+    }
+
+    cmd->int_promise.set_value(std::move(result));
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <hiredis.h>
+#include <async.h>
+#include <spdlog/spdlog.h>
+
+// Event-loop Redis client built on hiredis' redisAsyncContext.
+//
+// Unlike RedisClient, which dedicates a pooled blocking connection to each
+// in-flight command for its full round trip, AsyncRedisClient runs a single
+// reactor thread that pipelines every concurrent request over a small number
+// of sockets. Callers submit work from any thread and receive a std::future;
+// the reactor interleaves writes and reads so one connection can carry many
+// requests per RTT.
+class AsyncRedisClient {
+public:
+    AsyncRedisClient(std::string host, int port, size_t num_connections, int timeout_ms);
+    ~AsyncRedisClient();
+
+    AsyncRedisClient(const AsyncRedisClient&) = delete;
+    AsyncRedisClient& operator=(const AsyncRedisClient&) = delete;
+
+    // Future-based API: safe to call from any thread.
+    std::future<std::string> submit_ping();
+    std::future<std::string> submit_script_load(const std::string& script_content);
+    std::future<std::vector<long long>> submit_eval_sha(
+        const std::string& script_sha,
+        const std::vector<std::string>& keys,
+        const std::vector<long long>& args
+    );
+
+    // Blocking conveniences mirroring RedisClient's surface, including the
+    // NOSCRIPT fallback and internal key hashing.
+    std::string ping();
+    std::vector<long long> eval_script(
+        const std::string& script_sha,
+        const std::string& script_content,
+        const std::vector<std::string>& keys,
+        const std::vector<long long>& args,
+        const std::string& key_prefix = ""
+    );
+
+private:
+    // One queued command: fully marshalled argv plus the promise that carries
+    // the raw reply rows back to the submitter.
+    struct PendingCommand {
+        std::vector<std::string> argv;
+        std::promise<std::vector<long long>> int_promise;
+        std::promise<std::string> str_promise;
+        bool wants_string = false; // PING / SCRIPT LOAD vs EVALSHA
+    };
+
+    // Per-socket reactor bookkeeping, handed to the hiredis ev callbacks.
+    struct Connection {
+        AsyncRedisClient* parent = nullptr;
+        redisAsyncContext* ctx = nullptr;
+        bool want_read = false;
+        bool want_write = false;
+        bool connected = false;
+    };
+
+    std::string host;
+    int port;
+    int timeout_ms;
+
+    std::vector<std::unique_ptr<Connection>> connections;
+    size_t next_connection = 0; // round-robin, reactor thread only
+
+    std::mutex submit_mutex;
+    std::deque<std::unique_ptr<PendingCommand>> submit_queue;
+
+    int wake_pipe[2] = {-1, -1};
+    std::atomic<bool> stop_requested{false};
+    std::thread reactor;
+
+    void submit(std::unique_ptr<PendingCommand> cmd);
+    void wake_reactor();
+    void reactor_loop();
+    void drain_submit_queue();
+    Connection* pick_connection();
+    bool connect_one(Connection& conn);
+
+    // hiredis ev adapter hooks (run on the reactor thread)
+    static void ev_add_read(void* privdata);
+    static void ev_del_read(void* privdata);
+    static void ev_add_write(void* privdata);
+    static void ev_del_write(void* privdata);
+    static void ev_cleanup(void* privdata);
+
+    static void on_connect(const redisAsyncContext* ctx, int status);
+    static void on_disconnect(const redisAsyncContext* ctx, int status);
+    static void on_reply(redisAsyncContext* ctx, void* reply, void* privdata);
+};
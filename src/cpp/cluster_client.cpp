@@ -0,0 +1,474 @@
+#include "cluster_client.hpp"
+#include "eval_util.hpp"
+#include "sha256.hpp"
+#include <fmt/core.h>
+#include <cstdint>
+#include <sstream>
+
+// ============================================================================
+// ClusterClient Implementation
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Slot hashing (CRC16/XMODEM, per the Redis Cluster specification)
+// ----------------------------------------------------------------------------
+
+static uint16_t crc16(const char* data, size_t len) {
+    static uint16_t table[256];
+    static const bool init = []{
+        for (int i = 0; i < 256; i++) {
+            uint16_t crc = static_cast<uint16_t>(i << 8);
+            for (int j = 0; j < 8; j++) {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021)
+                                     : static_cast<uint16_t>(crc << 1);
+            }
+            table[i] = crc;
+        }
+        return true;
+    }();
+    (void)init;
+
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ table[((crc >> 8) ^ static_cast<uint8_t>(data[i])) & 0xFF]);
+    }
+    return crc;
+}
+
+int ClusterClient::hash_slot(const std::string& key) {
+    // {hash tag}: if the key contains a non-empty brace-delimited section,
+    // only that section is hashed, letting callers pin related keys together.
+    size_t open = key.find('{');
+    if (open != std::string::npos) {
+        size_t close = key.find('}', open + 1);
+        if (close != std::string::npos && close > open + 1) {
+            return crc16(key.data() + open + 1, close - open - 1) % 16384;
+        }
+    }
+    return crc16(key.data(), key.size()) % 16384;
+}
+
+// ----------------------------------------------------------------------------
+// Construction / teardown
+// ----------------------------------------------------------------------------
+
+ClusterClient::ClusterClient(const std::string& seed_nodes, size_t pool_size_per_node, int timeout_ms)
+    : pool_size_per_node(pool_size_per_node), timeout_ms(timeout_ms),
+      key_cache(10000) {
+
+    std::stringstream ss(seed_nodes);
+    std::string entry;
+    while (std::getline(ss, entry, ',')) {
+        size_t colon = entry.rfind(':');
+        if (colon == std::string::npos) continue;
+        std::string host = entry.substr(0, colon);
+        int port = 0;
+        try {
+            port = std::stoi(entry.substr(colon + 1));
+        } catch (...) {
+            continue;
+        }
+        if (!host.empty() && port > 0) seeds.emplace_back(host, port);
+    }
+
+    if (seeds.empty()) {
+        throw std::runtime_error("ClusterClient: no valid seed nodes in \"" + seed_nodes + "\"");
+    }
+
+    // Populate the slot map eagerly so the first check does not pay for the
+    // topology fetch. Failure here means no seed is reachable: surface it.
+    refresh_slot_map();
+}
+
+ClusterClient::~ClusterClient() = default;
+
+ClusterClient::NodePool::~NodePool() {
+    for (redisContext* ctx : idle) {
+        redisFree(ctx);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Node / connection management
+// ----------------------------------------------------------------------------
+
+redisContext* ClusterClient::connect_node(const NodePool& node) {
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    redisContext* ctx = redisConnectWithTimeout(node.host.c_str(), node.port, timeout);
+
+    if (ctx == nullptr || ctx->err) {
+        std::string err = ctx ? ctx->errstr : "Allocation failure";
+        if (ctx) redisFree(ctx);
+        throw std::runtime_error(fmt::format("Cluster node {}:{} connection failed: {}",
+                                             node.host, node.port, err));
+    }
+    return ctx;
+}
+
+redisContext* ClusterClient::checkout(NodePool& node) {
+    {
+        std::lock_guard<std::mutex> lock(node.mtx);
+        if (!node.idle.empty()) {
+            redisContext* ctx = node.idle.front();
+            node.idle.pop_front();
+            return ctx;
+        }
+        node.created++;
+    }
+    // Connect outside the lock; a failed connect gives the slot back.
+    try {
+        return connect_node(node);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(node.mtx);
+        node.created--;
+        throw;
+    }
+}
+
+void ClusterClient::checkin(NodePool& node, redisContext* ctx, bool healthy) {
+    if (!healthy || ctx->err) {
+        redisFree(ctx);
+        std::lock_guard<std::mutex> lock(node.mtx);
+        node.created--;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(node.mtx);
+    if (node.idle.size() >= pool_size_per_node) {
+        // Pool is full (connections created under burst); shed the extra.
+        redisFree(ctx);
+        node.created--;
+        return;
+    }
+    node.idle.push_back(ctx);
+}
+
+std::shared_ptr<ClusterClient::NodePool> ClusterClient::get_or_add_node(const std::string& host, int port) {
+    std::string id = fmt::format("{}:{}", host, port);
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    auto it = nodes.find(id);
+    if (it != nodes.end()) return it->second;
+
+    auto pool = std::make_shared<NodePool>();
+    pool->host = host;
+    pool->port = port;
+    nodes.emplace(std::move(id), pool);
+    return pool;
+}
+
+std::shared_ptr<ClusterClient::NodePool> ClusterClient::node_for_slot(int slot) {
+    auto map = std::atomic_load(&slot_map);
+    if (!map) return nullptr;
+    return map->slots[slot];
+}
+
+std::shared_ptr<ClusterClient::NodePool> ClusterClient::any_node() {
+    {
+        std::lock_guard<std::mutex> lock(topology_mutex);
+        if (!nodes.empty()) return nodes.begin()->second;
+    }
+    return get_or_add_node(seeds[0].first, seeds[0].second);
+}
+
+// ----------------------------------------------------------------------------
+// Topology
+// ----------------------------------------------------------------------------
+
+void ClusterClient::refresh_slot_map() {
+    spdlog::debug("ClusterClient: refreshing slot map");
+
+    // Try the known nodes first, then the seeds, until one answers.
+    std::vector<std::pair<std::string, int>> candidates;
+    {
+        std::lock_guard<std::mutex> lock(topology_mutex);
+        for (const auto& kv : nodes) {
+            candidates.emplace_back(kv.second->host, kv.second->port);
+        }
+    }
+    candidates.insert(candidates.end(), seeds.begin(), seeds.end());
+
+    std::string last_error = "no candidate nodes";
+
+    for (const auto& candidate : candidates) {
+        auto node = get_or_add_node(candidate.first, candidate.second);
+
+        redisContext* ctx = nullptr;
+        redisReply* reply = nullptr;
+        try {
+            ctx = checkout(*node);
+            reply = (redisReply*)redisCommand(ctx, "CLUSTER SLOTS");
+        } catch (const std::exception& e) {
+            last_error = e.what();
+            continue;
+        }
+
+        if (!reply || reply->type != REDIS_REPLY_ARRAY) {
+            last_error = fmt::format("CLUSTER SLOTS failed on {}:{}: {}",
+                                     candidate.first, candidate.second,
+                                     reply && reply->str ? reply->str : "network error");
+            if (reply) freeReplyObject(reply);
+            checkin(*node, ctx, false);
+            continue;
+        }
+
+        // Reply: array of [slot_start, slot_end, [master_ip, master_port, ...], replicas...]
+        auto map = std::make_shared<SlotMap>();
+        map->slots.resize(16384);
+
+        for (size_t i = 0; i < reply->elements; i++) {
+            redisReply* range = reply->element[i];
+            if (range->type != REDIS_REPLY_ARRAY || range->elements < 3) continue;
+            if (range->element[0]->type != REDIS_REPLY_INTEGER ||
+                range->element[1]->type != REDIS_REPLY_INTEGER) continue;
+
+            long long start = range->element[0]->integer;
+            long long end = range->element[1]->integer;
+            redisReply* master = range->element[2];
+            if (master->type != REDIS_REPLY_ARRAY || master->elements < 2) continue;
+            if (master->element[0]->type != REDIS_REPLY_STRING ||
+                master->element[1]->type != REDIS_REPLY_INTEGER) continue;
+
+            auto owner = get_or_add_node(master->element[0]->str,
+                                         static_cast<int>(master->element[1]->integer));
+            for (long long s = start; s <= end && s < 16384; s++) {
+                if (s >= 0) map->slots[s] = owner;
+            }
+        }
+
+        freeReplyObject(reply);
+        checkin(*node, ctx, true);
+
+        std::atomic_store(&slot_map, std::shared_ptr<const SlotMap>(std::move(map)));
+        spdlog::debug("ClusterClient: slot map refreshed via {}:{}",
+                      candidate.first, candidate.second);
+        return;
+    }
+
+    throw std::runtime_error("ClusterClient: slot map refresh failed: " + last_error);
+}
+
+// ----------------------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------------------
+
+std::string ClusterClient::ping() {
+    auto node = any_node();
+    redisContext* ctx = checkout(*node);
+
+    redisReply* reply = (redisReply*)redisCommand(ctx, "PING");
+    if (!reply) {
+        checkin(*node, ctx, false);
+        throw std::runtime_error("Redis command failed (Network error?)");
+    }
+
+    std::string response = (reply->type == REDIS_REPLY_STATUS) ? reply->str : "UNKNOWN";
+    freeReplyObject(reply);
+    checkin(*node, ctx, true);
+    return response;
+}
+
+std::string ClusterClient::load_script(const std::string& script_content) {
+    // Script caches are per-node; load everywhere so EVALSHA works on any
+    // master. Nodes that join later are covered by the NOSCRIPT fallback.
+    std::vector<std::shared_ptr<NodePool>> targets;
+    {
+        std::lock_guard<std::mutex> lock(topology_mutex);
+        for (const auto& kv : nodes) targets.push_back(kv.second);
+    }
+
+    std::string sha;
+    std::string last_error;
+
+    for (const auto& node : targets) {
+        redisContext* ctx = nullptr;
+        redisReply* reply = nullptr;
+        try {
+            ctx = checkout(*node);
+            reply = (redisReply*)redisCommand(ctx, "SCRIPT LOAD %s", script_content.c_str());
+        } catch (const std::exception& e) {
+            last_error = e.what();
+            continue;
+        }
+
+        if (reply && (reply->type == REDIS_REPLY_STRING || reply->type == REDIS_REPLY_STATUS)) {
+            sha = reply->str;
+            checkin(*node, ctx, true);
+        } else {
+            last_error = fmt::format("SCRIPT LOAD failed on {}:{}: {}",
+                                     node->host, node->port,
+                                     reply && reply->str ? reply->str : "network error");
+            checkin(*node, ctx, reply != nullptr);
+        }
+        if (reply) freeReplyObject(reply);
+    }
+
+    if (sha.empty()) {
+        throw std::runtime_error("ClusterClient: SCRIPT LOAD failed on every node: " + last_error);
+    }
+    return sha;
+}
+
+std::vector<long long> ClusterClient::eval_script(
+    const std::string& script_sha,
+    const std::string& script_content,
+    const std::vector<std::string>& raw_keys,
+    const std::vector<long long>& args,
+    const std::string& key_prefix
+) {
+    std::vector<std::string> hashed_keys;
+    hashed_keys.reserve(raw_keys.size());
+    for (const auto& k : raw_keys) {
+        hashed_keys.push_back(key_cache.get_or_compute(k, key_prefix));
+    }
+
+    // Routing picks one node from the slot of hashed_keys[0], so a multi-key
+    // script (fixed-window passes a companion queue key) would die with
+    // CROSSSLOT if its keys hashed independently. Rewrite companions as
+    // "{first}:<i>": hash_slot only hashes the brace-delimited tag, so they
+    // land on the routed slot, and the names stay deterministic per base key.
+    if (hashed_keys.size() > 1) {
+        const std::string tag = "{" + hashed_keys[0] + "}";
+        for (size_t i = 1; i < hashed_keys.size(); i++) {
+            hashed_keys[i] = tag + ":" + std::to_string(i);
+        }
+    }
+
+    try {
+        return eval_on_cluster(script_sha, script_content, hashed_keys, args);
+    } catch (const std::runtime_error& e) {
+        std::string err = e.what();
+        if (err == "NOSCRIPT") {
+            spdlog::warn("NOSCRIPT received, re-loading script on all nodes...");
+            load_script(script_content);
+            return eval_on_cluster(script_sha, script_content, hashed_keys, args);
+        }
+        throw;
+    }
+}
+
+std::vector<long long> ClusterClient::eval_on_cluster(
+    const std::string& script_sha,
+    const std::string& script_content,
+    const std::vector<std::string>& hashed_keys,
+    const std::vector<long long>& args
+) {
+    (void)script_content;
+
+    std::shared_ptr<NodePool> target;
+    if (!hashed_keys.empty()) {
+        target = node_for_slot(hash_slot(hashed_keys[0]));
+    }
+    if (!target) target = any_node();
+
+    bool asking = false;
+    std::string last_error;
+
+    // Redirect budget: a healthy cluster answers in one hop; during a slot
+    // migration MOVED/ASK chains stay short. Anything longer is a fault.
+    constexpr int kMaxRedirects = 5;
+
+    for (int attempt = 0; attempt <= kMaxRedirects; attempt++) {
+        redisContext* ctx = nullptr;
+        try {
+            ctx = checkout(*target);
+        } catch (const std::exception& e) {
+            // Node unreachable: refresh topology and retry on the new owner.
+            last_error = e.what();
+            refresh_slot_map();
+            if (!hashed_keys.empty()) {
+                auto owner = node_for_slot(hash_slot(hashed_keys[0]));
+                if (owner) target = owner;
+            }
+            continue;
+        }
+
+        if (asking) {
+            // ASK redirect: the importing node only serves the key after an
+            // explicit ASKING on the same connection.
+            redisReply* ask = (redisReply*)redisCommand(ctx, "ASKING");
+            if (!ask) {
+                checkin(*target, ctx, false);
+                last_error = "ASKING failed (Network error?)";
+                continue;
+            }
+            freeReplyObject(ask);
+            asking = false;
+        }
+
+        flux::EvalshaArgvBuilder argv(script_sha, hashed_keys, args);
+
+        redisReply* reply = (redisReply*)redisCommandArgv(
+            ctx,
+            argv.argc(),
+            argv.argv(),
+            argv.argvlen()
+        );
+
+        if (!reply) {
+            checkin(*target, ctx, false);
+            last_error = "Redis EVALSHA command failed (Network error?)";
+            continue;
+        }
+
+        if (reply->type == REDIS_REPLY_ERROR && reply->str) {
+            std::string err = reply->str;
+            bool moved = err.rfind("MOVED ", 0) == 0;
+            bool ask = err.rfind("ASK ", 0) == 0;
+            if (moved || ask) {
+                freeReplyObject(reply);
+                checkin(*target, ctx, true);
+
+                // "MOVED <slot> <host>:<port>" / "ASK <slot> <host>:<port>"
+                size_t sp = err.rfind(' ');
+                size_t colon = err.rfind(':');
+                if (sp == std::string::npos || colon == std::string::npos || colon <= sp) {
+                    throw std::runtime_error("ClusterClient: unparseable redirect: " + err);
+                }
+                std::string host = err.substr(sp + 1, colon - sp - 1);
+                // A proxy or truncated line can leave garbage after the
+                // colon; surface it as the repo's runtime_error instead of
+                // letting std::stoi escape as a bare ValueError in Python.
+                int port = 0;
+                try {
+                    port = std::stoi(err.substr(colon + 1));
+                } catch (...) {
+                    throw std::runtime_error("ClusterClient: unparseable redirect: " + err);
+                }
+                if (host.empty() || port <= 0 || port > 65535) {
+                    throw std::runtime_error("ClusterClient: unparseable redirect: " + err);
+                }
+
+                target = get_or_add_node(host, port);
+                if (moved) {
+                    // Ownership changed for good: refetch the whole map so
+                    // subsequent calls route directly.
+                    spdlog::debug("ClusterClient: MOVED redirect to {}:{}", host, port);
+                    try {
+                        refresh_slot_map();
+                    } catch (const std::exception& e) {
+                        spdlog::warn("ClusterClient: slot map refresh after MOVED failed: {}", e.what());
+                    }
+                } else {
+                    asking = true;
+                }
+                last_error = err;
+                continue;
+            }
+        }
+
+        try {
+            auto result = flux::parse_eval_reply(reply); // takes ownership
+            checkin(*target, ctx, true);
+            return result;
+        } catch (...) {
+            // Parse errors (NOSCRIPT, Lua errors) leave the connection usable.
+            checkin(*target, ctx, true);
+            throw;
+        }
+    }
+
+    throw std::runtime_error("ClusterClient: redirect budget exhausted: " + last_error);
+}
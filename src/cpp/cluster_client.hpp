@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <hiredis.h>
+#include <spdlog/spdlog.h>
+#include "lru_cache.hpp"
+
+// Redis Cluster client with hash-slot-aware routing.
+//
+// Every check touches a single key, so routing the EVALSHA straight to the
+// node that owns the key's slot avoids proxy hops and keeps tail latency
+// flat as the keyspace is sharded. The client keeps:
+//   - a CRC16/16384 slot map (refreshed from CLUSTER SLOTS on MOVED or on
+//     demand), swapped atomically so readers never lock;
+//   - one lazily-grown connection pool per master node;
+//   - MOVED/ASK redirect handling with a bounded redirect budget.
+//
+// Scripts are loaded per node on NOSCRIPT, mirroring RedisClient's fallback.
+class ClusterClient {
+public:
+    // seed_nodes: "host:port,host:port,..." -- any reachable subset suffices.
+    ClusterClient(const std::string& seed_nodes, size_t pool_size_per_node, int timeout_ms);
+    ~ClusterClient();
+
+    ClusterClient(const ClusterClient&) = delete;
+    ClusterClient& operator=(const ClusterClient&) = delete;
+
+    std::string ping();
+
+    // Load a script on every known master (scripts are per-node state).
+    std::string load_script(const std::string& script_content);
+
+    std::vector<long long> eval_script(
+        const std::string& script_sha,
+        const std::string& script_content,
+        const std::vector<std::string>& keys,
+        const std::vector<long long>& args,
+        const std::string& key_prefix = ""
+    );
+
+    // CRC16(XMODEM) % 16384 with {hash tag} support, as per the cluster spec.
+    static int hash_slot(const std::string& key);
+
+private:
+    struct NodePool {
+        std::string host;
+        int port = 0;
+
+        std::mutex mtx;
+        std::deque<redisContext*> idle;
+        size_t created = 0;
+
+        ~NodePool();
+    };
+
+    // Immutable snapshot: slot -> owning node. Swapped wholesale on refresh.
+    struct SlotMap {
+        std::vector<std::shared_ptr<NodePool>> slots; // size 16384
+    };
+
+    std::vector<std::pair<std::string, int>> seeds;
+    size_t pool_size_per_node;
+    int timeout_ms;
+
+    std::mutex topology_mutex; // guards nodes + slot map refresh
+    std::unordered_map<std::string, std::shared_ptr<NodePool>> nodes; // "host:port"
+    std::shared_ptr<const SlotMap> slot_map; // atomic load/store
+
+    HashedKeyCache key_cache;
+
+    std::shared_ptr<NodePool> node_for_slot(int slot);
+    std::shared_ptr<NodePool> get_or_add_node(const std::string& host, int port);
+    std::shared_ptr<NodePool> any_node();
+
+    redisContext* checkout(NodePool& node);
+    void checkin(NodePool& node, redisContext* ctx, bool healthy);
+    redisContext* connect_node(const NodePool& node);
+
+    // Pull CLUSTER SLOTS from any reachable node and swap the map.
+    void refresh_slot_map();
+
+    // Executes one EVALSHA on the owning node, following MOVED/ASK.
+    std::vector<long long> eval_on_cluster(
+        const std::string& script_sha,
+        const std::string& script_content,
+        const std::vector<std::string>& hashed_keys,
+        const std::vector<long long>& args
+    );
+};
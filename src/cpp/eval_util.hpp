@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <fmt/core.h>
+#include <hiredis.h>
+
+// Internal helpers shared by the pooled, cluster, and multiplexed clients:
+// EVALSHA argv marshalling and reply parsing for the rate-limit scripts.
+namespace flux {
+
+// Marshals one EVALSHA invocation into hiredis argv form without touching the
+// heap for the common call shape (<= 2 keys, <= 10 numeric args): the argv
+// pointer/length tables live in inline arrays and integers are formatted with
+// fmt::format_int into an inline char arena. Oversized calls fall back to
+// one-shot heap blocks sized exactly up front, so pointers never move after
+// being stored (the old vector-based builder could reallocate mid-build and
+// invalidate c_str() pointers already handed out).
+//
+// The builder borrows `script_sha` and `keys`; they must outlive it.
+class EvalshaArgvBuilder {
+public:
+    EvalshaArgvBuilder(
+        const std::string& script_sha,
+        const std::vector<std::string>& keys,
+        const std::vector<long long>& args
+    ) : count(3 + keys.size() + args.size()) {
+        const char** argv = argv_inline;
+        size_t* lens = len_inline;
+        if (count > kInlineArgs) {
+            argv_heap.reset(new const char*[count]);
+            len_heap.reset(new size_t[count]);
+            argv = argv_heap.get();
+            lens = len_heap.get();
+        }
+
+        // Worst case per long long: sign + 19 digits. +1 slot for numkeys.
+        size_t arena_need = 20 * (args.size() + 1);
+        char* cursor = arena_inline;
+        if (arena_need > sizeof(arena_inline)) {
+            arena_heap.reset(new char[arena_need]);
+            cursor = arena_heap.get();
+        }
+
+        size_t n = 0;
+        argv[n] = "EVALSHA";
+        lens[n++] = 7;
+
+        argv[n] = script_sha.c_str();
+        lens[n++] = script_sha.size();
+
+        auto put_int = [&](long long v) {
+            fmt::format_int f(v);
+            std::memcpy(cursor, f.data(), f.size());
+            argv[n] = cursor;
+            lens[n++] = f.size();
+            cursor += f.size();
+        };
+
+        put_int(static_cast<long long>(keys.size()));
+
+        for (const auto& key : keys) {
+            argv[n] = key.c_str();
+            lens[n++] = key.size();
+        }
+
+        for (long long arg : args) {
+            put_int(arg);
+        }
+
+        argv_ptr = argv;
+        len_ptr = lens;
+    }
+
+    EvalshaArgvBuilder(const EvalshaArgvBuilder&) = delete;
+    EvalshaArgvBuilder& operator=(const EvalshaArgvBuilder&) = delete;
+
+    int argc() const { return static_cast<int>(count); }
+    const char** argv() const { return const_cast<const char**>(argv_ptr); }
+    const size_t* argvlen() const { return len_ptr; }
+
+private:
+    // EVALSHA + sha + numkeys + 2 keys + 10 args.
+    static constexpr size_t kInlineArgs = 15;
+
+    size_t count;
+    const char** argv_ptr = nullptr;
+    const size_t* len_ptr = nullptr;
+
+    const char* argv_inline[kInlineArgs];
+    size_t len_inline[kInlineArgs];
+    char arena_inline[20 * 11];
+
+    std::unique_ptr<const char*[]> argv_heap;
+    std::unique_ptr<size_t[]> len_heap;
+    std::unique_ptr<char[]> arena_heap;
+};
+
+// Convert an EVALSHA reply into the flat integer vector our Lua scripts
+// return. Takes ownership of `reply` and frees it on every path.
+inline std::vector<long long> parse_eval_reply(redisReply* reply) {
+    if (!reply) {
+        throw std::runtime_error("Redis EVALSHA command failed (Network error?)");
+    }
+
+    if (reply->type == REDIS_REPLY_ERROR &&
+        std::string(reply->str).find("NOSCRIPT") != std::string::npos) {
+        freeReplyObject(reply);
+        throw std::runtime_error("NOSCRIPT");
+    }
+
+    std::vector<long long> result;
+
+    if (reply->type == REDIS_REPLY_ARRAY) {
+        result.reserve(reply->elements);
+        for(size_t i = 0; i < reply->elements; i++) {
+            if(reply->element[i]->type == REDIS_REPLY_INTEGER) {
+                result.push_back(reply->element[i]->integer);
+            } else if(reply->element[i]->type == REDIS_REPLY_STRING) {
+                 // Try to convert string to long long if needed, or just 0
+                 try {
+                    result.push_back(std::stoll(reply->element[i]->str));
+                 } catch (...) {
+                     result.push_back(0);
+                 }
+            } else {
+                 result.push_back(0); // Fallback
+            }
+        }
+    } else if (reply->type == REDIS_REPLY_ERROR) {
+        std::string error = reply->str;
+        freeReplyObject(reply);
+        throw std::runtime_error("Lua error: " + error);
+    } else if (reply->type == REDIS_REPLY_INTEGER) {
+        // Single integer return (shouldn't happen with our scripts but safe to handle)
+        result.push_back(reply->integer);
+    } else {
+        freeReplyObject(reply);
+        throw std::runtime_error("Unexpected reply type");
+    }
+
+    freeReplyObject(reply);
+    return result;
+}
+
+} // namespace flux
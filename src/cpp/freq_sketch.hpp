@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// Count-min frequency sketch with periodic decay.
+//
+// Tracks approximate per-key request counts in a fixed few KB of memory so
+// the hot-key sharder can notice a viral key without keeping a counter per
+// key. Four rows of relaxed atomic counters; an update increments one
+// counter per row and the estimate is the minimum across rows, so hash
+// collisions can only over-count, never under-count — a key reported cold is
+// genuinely cold. decay() halves every counter, turning lifetime counts into
+// a sliding estimate of the recent window; the slight raciness against
+// concurrent increments just blurs the estimate, which is all it is anyway.
+class FreqSketch {
+public:
+    explicit FreqSketch(size_t counters_per_row = 2048)
+        : mask(round_up_pow2(counters_per_row) - 1),
+          counters(kRows * (mask + 1)) {}
+
+    FreqSketch(const FreqSketch&) = delete;
+    FreqSketch& operator=(const FreqSketch&) = delete;
+
+    // Count one occurrence and return the new estimate for the key.
+    uint32_t add(const std::string& key) {
+        uint64_t h = std::hash<std::string>{}(key);
+        uint32_t est = UINT32_MAX;
+        for (size_t row = 0; row < kRows; row++) {
+            auto& cell = counters[row * (mask + 1) + (mix(h, kSeeds[row]) & mask)];
+            uint32_t v = cell.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (v < est) est = v;
+        }
+        return est;
+    }
+
+    uint32_t estimate(const std::string& key) const {
+        uint64_t h = std::hash<std::string>{}(key);
+        uint32_t est = UINT32_MAX;
+        for (size_t row = 0; row < kRows; row++) {
+            uint32_t v = counters[row * (mask + 1) + (mix(h, kSeeds[row]) & mask)]
+                             .load(std::memory_order_relaxed);
+            if (v < est) est = v;
+        }
+        return est;
+    }
+
+    // Halve every counter; call once per detection window.
+    void decay() {
+        for (auto& cell : counters) {
+            uint32_t v = cell.load(std::memory_order_relaxed);
+            if (v > 0) cell.store(v >> 1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static constexpr size_t kRows = 4;
+    static constexpr uint64_t kSeeds[kRows] = {
+        0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL,
+        0x94d049bb133111ebULL, 0xd6e8feb86659fd93ULL,
+    };
+
+    static size_t round_up_pow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // splitmix64 finalizer: decorrelates the rows from one base hash.
+    static uint64_t mix(uint64_t h, uint64_t seed) {
+        uint64_t z = h ^ seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    size_t mask;
+    std::vector<std::atomic<uint32_t>> counters;
+};
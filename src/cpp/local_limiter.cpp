@@ -0,0 +1,118 @@
+#include "local_limiter.hpp"
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+// ============================================================================
+// LocalLimiter Implementation
+// ============================================================================
+
+LocalLimiter::LocalLimiter(size_t max_keys_per_shard)
+    : max_keys_per_shard(max_keys_per_shard == 0 ? 1 : max_keys_per_shard) {}
+
+LocalLimiter::Shard& LocalLimiter::shard_for(const std::string& key) {
+    return shards[std::hash<std::string>{}(key) % kShards];
+}
+
+void LocalLimiter::maybe_sweep(Shard& shard, long long now_ms) {
+    // Called with the shard lock held. Amortized TTL eviction: a full sweep
+    // every kSweepInterval ops, or immediately when the shard is at capacity.
+    shard.ops++;
+    bool at_capacity = shard.entries.size() >= max_keys_per_shard;
+    if (shard.ops % kSweepInterval != 0 && !at_capacity) return;
+
+    for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+        if (it->second.expires_at_ms <= now_ms) it = shard.entries.erase(it);
+        else ++it;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// GCRA (mirrors gcra.lua)
+// ----------------------------------------------------------------------------
+
+std::vector<long long> LocalLimiter::check_gcra(
+    const std::string& key,
+    long long emission_interval_ms,
+    long long delay_tolerance_ms,
+    long long now_ms
+) {
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    maybe_sweep(shard, now_ms);
+
+    long long tat = 0;
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end() && it->second.expires_at_ms > now_ms) {
+        tat = it->second.tat_ms;
+    }
+
+    long long new_tat = std::max(now_ms, tat) + emission_interval_ms;
+    long long allow_at = new_tat - delay_tolerance_ms;
+
+    if (now_ms < allow_at) {
+        // Rate limit exceeded
+        long long retry_after = (allow_at - now_ms + 999) / 1000; // seconds, rounded up
+        long long current_usage = std::max(0LL, tat - now_ms);
+        return {-1, retry_after, current_usage};
+    }
+
+    // Allow the request; same TTL the script sets via PX
+    Entry& entry = shard.entries[key];
+    entry.tat_ms = new_tat;
+    entry.expires_at_ms = now_ms + delay_tolerance_ms * 2;
+    long long current_usage = std::max(0LL, new_tat - now_ms);
+    return {0, new_tat, current_usage};
+}
+
+// ----------------------------------------------------------------------------
+// Token Bucket (mirrors token_bucket.lua)
+// ----------------------------------------------------------------------------
+
+std::vector<long long> LocalLimiter::check_token_bucket(
+    const std::string& key,
+    long long capacity,
+    long long refill_time_ms,
+    long long now_ms
+) {
+    double refill_rate = 1000.0 / (double)refill_time_ms; // tokens per second
+
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    maybe_sweep(shard, now_ms);
+
+    long long tokens = capacity;
+    long long last_refill = now_ms;
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end() && it->second.expires_at_ms > now_ms) {
+        tokens = it->second.tokens;
+        last_refill = it->second.last_refill_ms;
+    }
+
+    // Refill tokens based on elapsed time
+    double elapsed_seconds = (now_ms - last_refill) / 1000.0;
+    if (elapsed_seconds > 0) {
+        long long tokens_to_add = (long long)std::floor(elapsed_seconds * refill_rate);
+        tokens = std::min(capacity, tokens + tokens_to_add);
+        last_refill = now_ms;
+    }
+
+    long long ttl_ms = (long long)std::ceil((capacity / refill_rate) * 2) * 1000;
+
+    Entry& entry = shard.entries[key];
+    entry.last_refill_ms = last_refill;
+    entry.expires_at_ms = now_ms + ttl_ms;
+
+    if (tokens >= 1) {
+        tokens -= 1;
+        entry.tokens = tokens;
+        long long current_usage = capacity - tokens;
+        return {0, tokens, current_usage};
+    }
+
+    entry.tokens = tokens;
+    long long current_usage = capacity - tokens;
+    long long time_until_next_token = (long long)std::ceil((1.0 / refill_rate) * 1000); // ms
+    long long retry_after = (time_until_next_token + 999) / 1000; // seconds
+    return {-1, retry_after, current_usage};
+}
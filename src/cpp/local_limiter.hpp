@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <array>
+#include <unordered_map>
+#include <cstdint>
+
+// Embedded in-memory rate-limit engine for single-instance deployments where
+// Redis would exist solely to host the limiter state.
+//
+// Implements GCRA and token bucket with the same argument and result
+// conventions as src/flux/lua/gcra.lua and token_bucket.lua ({status, value,
+// usage} with status 0 = allowed, -1 = denied), backed by a sharded hash map
+// with striped locks. State carries the same TTL the scripts set via PX/EXPIRE
+// and expired entries are swept opportunistically, so idle keys are reclaimed
+// without a background thread.
+class LocalLimiter {
+public:
+    explicit LocalLimiter(size_t max_keys_per_shard = 65536);
+
+    LocalLimiter(const LocalLimiter&) = delete;
+    LocalLimiter& operator=(const LocalLimiter&) = delete;
+
+    // Mirrors gcra.lua: ARGV = emission_interval_ms, delay_tolerance_ms, now_ms
+    std::vector<long long> check_gcra(
+        const std::string& key,
+        long long emission_interval_ms,
+        long long delay_tolerance_ms,
+        long long now_ms
+    );
+
+    // Mirrors token_bucket.lua: ARGV = capacity, refill_time_ms, now_ms
+    std::vector<long long> check_token_bucket(
+        const std::string& key,
+        long long capacity,
+        long long refill_time_ms,
+        long long now_ms
+    );
+
+private:
+    static constexpr size_t kShards = 64;
+    // Sweep an entire shard for expired entries every this many operations.
+    static constexpr uint64_t kSweepInterval = 1024;
+
+    struct Entry {
+        // GCRA state
+        long long tat_ms = 0;
+        // Token bucket state
+        long long tokens = 0;
+        long long last_refill_ms = 0;
+        // Shared TTL, in the caller's now_ms clock
+        long long expires_at_ms = 0;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, Entry> entries;
+        uint64_t ops = 0;
+    };
+
+    std::array<Shard, kShards> shards;
+    size_t max_keys_per_shard;
+
+    Shard& shard_for(const std::string& key);
+    void maybe_sweep(Shard& shard, long long now_ms);
+};
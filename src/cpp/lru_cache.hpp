@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <mutex>
+#include <array>
+#include <unordered_map>
+#include <functional>
+#include "sha256.hpp"
+
+// Bounded, sharded LRU cache mapping a raw rate-limit key to its final
+// prefixed SHA-256 key.
+//
+// Key populations are heavily skewed in practice (a few thousand hot client
+// identities dominate), so a hot hit replaces a full SHA-256 plus two string
+// allocations with one hash-table lookup. Sharded 16 ways so concurrent
+// checks rarely contend on the same lock; each shard keeps its own LRU list.
+// A capacity of 0 disables caching and computes every key directly.
+class HashedKeyCache {
+public:
+    explicit HashedKeyCache(size_t capacity) : total_capacity(capacity) {
+        per_shard_capacity = capacity / kShards;
+        if (capacity > 0 && per_shard_capacity == 0) per_shard_capacity = 1;
+    }
+
+    HashedKeyCache(const HashedKeyCache&) = delete;
+    HashedKeyCache& operator=(const HashedKeyCache&) = delete;
+
+    bool enabled() const { return total_capacity > 0; }
+
+    // prefix + hex(sha256(raw_key)), cached. The prefix is stored with the
+    // entry and re-checked on hit so a caller using a different prefix can
+    // never be served a stale concatenation.
+    std::string get_or_compute(const std::string& raw_key, const std::string& prefix) {
+        if (!enabled()) return sha256_key(prefix, raw_key);
+
+        Shard& shard = shards[std::hash<std::string>{}(raw_key) % kShards];
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto it = shard.entries.find(raw_key);
+            if (it != shard.entries.end() && it->second.prefix == prefix) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+                return it->second.final_key;
+            }
+        }
+
+        // Miss: hash outside the lock; a racing duplicate compute is harmless.
+        std::string final_key = sha256_key(prefix, raw_key);
+
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.entries.find(raw_key);
+        if (it != shard.entries.end()) {
+            it->second.prefix = prefix;
+            it->second.final_key = final_key;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+            return final_key;
+        }
+
+        shard.lru.push_front(raw_key);
+        shard.entries[raw_key] = Entry{prefix, final_key, shard.lru.begin()};
+
+        while (shard.entries.size() > per_shard_capacity) {
+            shard.entries.erase(shard.lru.back());
+            shard.lru.pop_back();
+        }
+        return final_key;
+    }
+
+private:
+    static constexpr size_t kShards = 16;
+
+    struct Entry {
+        std::string prefix;
+        std::string final_key;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> lru; // front = most recently used
+    };
+
+    std::array<Shard, kShards> shards;
+    size_t total_capacity;
+    size_t per_shard_capacity;
+};
@@ -1,31 +1,463 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include "redis_client.hpp"
+#include "async_client.hpp"
+#include "multiplex_client.hpp"
+#include "cluster_client.hpp"
+#include "local_limiter.hpp"
 
 namespace py = pybind11;
 
+namespace {
+
+// Bridges blocking RedisClient::eval_script calls onto asyncio.
+//
+// submit() runs on the event-loop thread: it parks the marshalled call on a
+// small worker pool and returns an asyncio Future immediately, so the loop
+// never blocks on the Redis RTT. A worker executes the blocking call with
+// the GIL released (the same pooled path the sync binding uses, retries and
+// caches included) and completes the Future back on its loop via
+// call_soon_threadsafe. Workers are started lazily on first use and stopped
+// from a Python atexit hook, while the interpreter can still run loop
+// callbacks.
+class AsyncEvalBridge {
+public:
+    static AsyncEvalBridge& instance() {
+        static AsyncEvalBridge bridge;
+        return bridge;
+    }
+
+    // GIL held (called from Python). A non-empty `name` routes through the
+    // script registry (eval_by_name); otherwise sha/content are used as-is.
+    py::object submit(py::object client_obj, const std::string& name,
+                      const std::string& sha, const std::string& content,
+                      const std::vector<std::string>& keys,
+                      const std::vector<long long>& args,
+                      const std::string& prefix, int deadline_ms) {
+        py::object loop = py::module_::import("asyncio").attr("get_running_loop")();
+        py::object future = loop.attr("create_future")();
+
+        auto job = std::make_unique<Job>();
+        job->client = &client_obj.cast<RedisClient&>();
+        job->client_ref = client_obj; // keeps the client alive until completion
+        job->name = name;
+        job->sha = sha;
+        job->content = content;
+        job->keys = keys;
+        job->args = args;
+        job->prefix = prefix;
+        job->deadline_ms = deadline_ms;
+        job->loop = loop;
+        job->future = future;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (stopping) throw std::runtime_error("Interpreter is shutting down");
+            ensure_workers_locked();
+            queue.push_back(std::move(job));
+        }
+        cv.notify_one();
+        return future;
+    }
+
+    // Called from Python atexit with the GIL held: workers are joined with
+    // the GIL released so in-flight completions can still acquire it.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        {
+            py::gil_scoped_release release;
+            for (auto& t : workers) {
+                if (t.joinable()) t.join();
+            }
+        }
+        workers.clear();
+        queue.clear(); // drops any leftover py handles under the GIL
+    }
+
+private:
+    struct Job {
+        RedisClient* client;
+        py::object client_ref;
+        std::string name; // non-empty: resolve sha/content from the registry
+        std::string sha, content, prefix;
+        std::vector<std::string> keys;
+        std::vector<long long> args;
+        int deadline_ms;
+        py::object loop, future;
+    };
+
+    // Workers spend their time blocked on Redis I/O; eight is enough to
+    // saturate the default pool from one event loop.
+    static constexpr size_t kWorkers = 8;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::unique_ptr<Job>> queue;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    void ensure_workers_locked() {
+        if (!workers.empty()) return;
+        workers.reserve(kWorkers);
+        for (size_t i = 0; i < kWorkers; i++) {
+            workers.emplace_back(&AsyncEvalBridge::worker_loop, this);
+        }
+    }
+
+    void worker_loop() {
+        // No GIL here: the blocking eval below must not stall the interpreter.
+        while (true) {
+            std::unique_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return stopping || !queue.empty(); });
+                if (queue.empty()) return; // stopping and drained
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            std::vector<long long> result;
+            std::string error;
+            try {
+                if (!job->name.empty()) {
+                    result = job->client->eval_by_name(job->name, job->keys,
+                                                       job->args, job->prefix,
+                                                       job->deadline_ms);
+                } else {
+                    result = job->client->eval_script(job->sha, job->content,
+                                                      job->keys, job->args,
+                                                      job->prefix,
+                                                      job->deadline_ms);
+                }
+            } catch (const std::exception& e) {
+                error = e.what();
+                if (error.empty()) error = "Redis command failed";
+            }
+
+            py::gil_scoped_acquire gil;
+            try {
+                if (error.empty()) {
+                    job->loop.attr("call_soon_threadsafe")(
+                        py::cpp_function([](py::object fut, py::object value) {
+                            if (!fut.attr("cancelled")().cast<bool>()) {
+                                fut.attr("set_result")(value);
+                            }
+                        }),
+                        job->future, py::cast(result));
+                } else {
+                    job->loop.attr("call_soon_threadsafe")(
+                        py::cpp_function([](py::object fut, py::object exc) {
+                            if (!fut.attr("cancelled")().cast<bool>()) {
+                                fut.attr("set_exception")(exc);
+                            }
+                        }),
+                        job->future,
+                        py::module_::import("builtins").attr("RuntimeError")(error));
+                }
+            } catch (const py::error_already_set&) {
+                // Loop already closed; the caller is gone anyway.
+            }
+            job.reset(); // py handles released while we still hold the GIL
+        }
+    }
+};
+
+} // namespace
+
 PYBIND11_MODULE(_flux_core, m) {
     m.doc() = "Flux Core: High-performance C++ Rate Limiter Engine";
 
+    // Stop the async-eval workers while the interpreter can still run loop
+    // callbacks; a plain C++ static destructor would race interpreter
+    // teardown.
+    py::module_::import("atexit").attr("register")(
+        py::cpp_function([]() { AsyncEvalBridge::instance().shutdown(); }));
+
+    m.def("set_log_level", [](const std::string& level) {
+        spdlog::set_level(spdlog::level::from_str(level));
+    },
+          py::arg("level"),
+          "Set the runtime log level (\"trace\", \"debug\", \"info\", \"warn\", "
+          "\"error\", \"critical\", \"off\") without restarting. Statements "
+          "compiled out via SPDLOG_ACTIVE_LEVEL stay off regardless.");
+
+    // All methods that touch the network carry py::call_guard<gil_scoped_release>
+    // so other Python threads keep running during the Redis round trip. pybind11
+    // converts the keys/args lists into C++ vectors before the guard is
+    // constructed and converts the return value after it is destroyed, so no
+    // STL conversion ever runs without the GIL.
+
     py::class_<RedisClient>(m, "RedisClient")
-        .def(py::init([](const std::string& host, int port, int pool_size, int timeout_ms, const std::string& log_path, bool enable_console_logging) {
-            return new RedisClient(host, port, static_cast<size_t>(pool_size), timeout_ms, log_path, enable_console_logging);
-        }), 
-             py::arg("host") = "127.0.0.1", 
+        .def(py::init([](const std::string& host, int port, int pool_size, int timeout_ms, const std::string& log_path, bool enable_console_logging, bool enable_denial_cache, int key_cache_size, const std::string& shm_cache_name, const std::string& unix_socket_path, bool circuit_fail_open, int min_pool_size, bool thread_affinity) {
+            return new RedisClient(host, port, static_cast<size_t>(pool_size), timeout_ms, log_path, enable_console_logging, enable_denial_cache,
+                                   key_cache_size < 0 ? 0 : static_cast<size_t>(key_cache_size),
+                                   shm_cache_name, unix_socket_path, circuit_fail_open,
+                                   min_pool_size < 0 ? 0 : static_cast<size_t>(min_pool_size),
+                                   thread_affinity);
+        }),
+             py::arg("host") = "127.0.0.1",
              py::arg("port") = 6379,
              py::arg("pool_size") = 5,
              py::arg("timeout_ms") = 200,
              py::arg("log_file") = "flux_debug.log",
              py::arg("enable_console_logging") = false,
-             "Initialize Redis Connection Pool")
-        .def("ping", &RedisClient::ping, "Thread-safe PING")
-        .def("load_script", &RedisClient::load_script, "Cache Lua script on Redis. Returns SHA1.")
-        .def("eval_sha", &RedisClient::eval_sha, "Execute cached script by SHA1.")
+             py::arg("enable_denial_cache") = true,
+             py::arg("key_cache_size") = 10000,
+             py::arg("shm_cache_name") = "",
+             py::arg("unix_socket_path") = "",
+             py::arg("circuit_fail_open") = true,
+             py::arg("min_pool_size") = 0,
+             py::arg("thread_affinity") = false,
+             "Initialize Redis Connection Pool. A non-empty unix_socket_path "
+             "connects over a Unix domain socket instead of host/port. "
+             "circuit_fail_open picks the verdict (allow/deny) served while "
+             "the circuit breaker is open. The pool is warmed with parallel "
+             "connects; min_pool_size > 0 returns from init once that many "
+             "connections are ready and grows to pool_size in the background. "
+             "thread_affinity pins a sticky connection per calling thread "
+             "(best when thread count <= pool_size); the shared pool remains "
+             "the fallback and idle sticky connections are reclaimed.")
+        .def("ping", &RedisClient::ping,
+             py::call_guard<py::gil_scoped_release>(),
+             "Thread-safe PING")
+        .def("load_script", &RedisClient::load_script,
+             py::call_guard<py::gil_scoped_release>(),
+             "Cache Lua script on Redis. Returns SHA1.")
+        .def("register_script", &RedisClient::register_script,
+             py::arg("name"),
+             py::arg("script_content"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Load a script into Redis once and remember it under a name, so "
+             "eval_by_name never carries the script body. Returns SHA1.")
+        .def("eval_by_name", &RedisClient::eval_by_name,
+             py::arg("name"),
+             py::arg("keys"),
+             py::arg("args"),
+             py::arg("key_prefix") = "",
+             py::arg("deadline_ms") = 0,
+             py::call_guard<py::gil_scoped_release>(),
+             "Execute a registered script by name; the NOSCRIPT fallback is "
+             "fed from the registry instead of a per-call payload. "
+             "deadline_ms > 0 bounds the whole call, retries included.")
+        .def("eval_sha", &RedisClient::eval_sha,
+             py::arg("script_sha"),
+             py::arg("keys"),
+             py::arg("args"),
+             py::arg("deadline_ms") = 0,
+             py::call_guard<py::gil_scoped_release>(),
+             "Execute cached script by SHA1. deadline_ms > 0 bounds the whole "
+             "call (all retry attempts included); 0 uses the per-attempt "
+             "timeout only.")
         .def("eval_script", &RedisClient::eval_script,
              py::arg("script_sha"),
              py::arg("script_content"),
              py::arg("keys"),
              py::arg("args"),
              py::arg("key_prefix") = "",
-             "Execute with automatic fallback (EVALSHA -> SCRIPT LOAD -> EVALSHA). Hashing is performed internally.");
+             py::arg("deadline_ms") = 0,
+             py::call_guard<py::gil_scoped_release>(),
+             "Execute with automatic fallback (EVALSHA -> SCRIPT LOAD -> EVALSHA). Hashing is performed internally. "
+             "deadline_ms > 0 bounds the whole call, retries included.")
+        .def("eval_script_async", [](py::object self, const std::string& script_sha,
+                                     const std::string& script_content,
+                                     const std::vector<std::string>& keys,
+                                     const std::vector<long long>& args,
+                                     const std::string& key_prefix, int deadline_ms) {
+            return AsyncEvalBridge::instance().submit(
+                self, "", script_sha, script_content, keys, args, key_prefix, deadline_ms);
+        },
+             py::arg("script_sha"),
+             py::arg("script_content"),
+             py::arg("keys"),
+             py::arg("args"),
+             py::arg("key_prefix") = "",
+             py::arg("deadline_ms") = 0,
+             "Awaitable eval_script for asyncio: returns an asyncio Future "
+             "immediately and completes it from a C++ worker thread when the "
+             "reply arrives, so the event loop never blocks on the Redis RTT. "
+             "Must be called from a running event loop.")
+        .def("eval_by_name_async", [](py::object self, const std::string& name,
+                                      const std::vector<std::string>& keys,
+                                      const std::vector<long long>& args,
+                                      const std::string& key_prefix, int deadline_ms) {
+            return AsyncEvalBridge::instance().submit(
+                self, name, "", "", keys, args, key_prefix, deadline_ms);
+        },
+             py::arg("name"),
+             py::arg("keys"),
+             py::arg("args"),
+             py::arg("key_prefix") = "",
+             py::arg("deadline_ms") = 0,
+             "Awaitable eval_by_name: like eval_script_async but resolves the "
+             "script through the registry, so the call never carries the "
+             "script body. Must be called from a running event loop.")
+        .def("eval_script_batch", &RedisClient::eval_script_batch,
+             py::arg("script_sha"),
+             py::arg("script_content"),
+             py::arg("calls"),
+             py::arg("key_prefix") = "",
+             py::call_guard<py::gil_scoped_release>(),
+             "Execute a batch of (keys, args) invocations of one script in a single "
+             "pipelined round trip. Returns one result list per invocation, in order.")
+        .def("enable_hot_key_sharding", &RedisClient::enable_hot_key_sharding,
+             py::arg("num_shards"),
+             py::arg("hot_threshold"),
+             py::arg("policy"),
+             py::arg("rebalance_script") = "",
+             py::call_guard<py::gil_scoped_release>(),
+             "Enable automatic hot-key sharding: keys crossing hot_threshold "
+             "requests per ~5s window are fanned out across num_shards "
+             "sub-keys, each granted rate/N. rebalance_script is the content "
+             "of shard_rebalance.lua (empty disables drift rebalancing).")
+        .def("enable_analytics", &RedisClient::enable_analytics,
+             py::arg("stream_key"),
+             py::arg("maxlen"),
+             py::arg("ring_capacity") = 8192,
+             py::call_guard<py::gil_scoped_release>(),
+             "Start the background analytics batcher: events recorded via "
+             "record_analytics_event are flushed as pipelined XADDs off the "
+             "request path.")
+        .def("record_analytics_event", &RedisClient::record_analytics_event,
+             py::arg("hashed_key"),
+             py::arg("endpoint"),
+             py::arg("allowed"),
+             py::arg("policy"),
+             py::arg("usage"),
+             py::arg("meta_requests"),
+             py::arg("meta_period"),
+             py::arg("meta_burst"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Enqueue one analytics event into the bounded ring "
+             "(drop-oldest under backpressure). Never blocks.")
+        .def("get_metrics", &RedisClient::get_metrics,
+             py::call_guard<py::gil_scoped_release>(),
+             "Snapshot the core's lock-free metrics: check/allow/deny/retry "
+             "counters plus p50/p90/p99/p99.9/max (microseconds) for eval_sha "
+             "round trips and connection checkout waits. Safe to scrape at "
+             "any rate.")
+        .def("read_cached", &RedisClient::read_cached,
+             py::arg("command"),
+             py::arg("key"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Cached read (GET/HGETALL/SMEMBERS) over a RESP3 CLIENT TRACKING "
+             "connection: results are served in-process until Redis pushes an "
+             "invalidation for the key. Returns a flat list of strings.")
+        .def("lease_check", &RedisClient::lease_check,
+             py::arg("script_sha"),
+             py::arg("script_content"),
+             py::arg("key"),
+             py::arg("capacity"),
+             py::arg("refill_time_ms"),
+             py::arg("batch_size"),
+             py::arg("key_prefix") = "",
+             py::call_guard<py::gil_scoped_release>(),
+             "Token-lease check: batch-reserve tokens from Redis (token_lease.lua) "
+             "and serve checks from a local counter, refreshing in the background.");
+
+    py::class_<AsyncRedisClient>(m, "AsyncRedisClient")
+        .def(py::init([](const std::string& host, int port, int num_connections, int timeout_ms) {
+            return new AsyncRedisClient(host, port, static_cast<size_t>(num_connections), timeout_ms);
+        }),
+             py::arg("host") = "127.0.0.1",
+             py::arg("port") = 6379,
+             py::arg("num_connections") = 2,
+             py::arg("timeout_ms") = 200,
+             "Initialize event-loop client: a reactor thread pipelines all requests "
+             "over a small number of connections.")
+        .def("ping", &AsyncRedisClient::ping,
+             py::call_guard<py::gil_scoped_release>(),
+             "Thread-safe PING")
+        .def("eval_script", &AsyncRedisClient::eval_script,
+             py::arg("script_sha"),
+             py::arg("script_content"),
+             py::arg("keys"),
+             py::arg("args"),
+             py::arg("key_prefix") = "",
+             py::call_guard<py::gil_scoped_release>(),
+             "Execute with automatic fallback (EVALSHA -> SCRIPT LOAD -> EVALSHA). "
+             "Requests from all threads are pipelined by the reactor.");
+
+    py::class_<MultiplexClient>(m, "MultiplexClient")
+        .def(py::init([](const std::string& host, int port, int num_connections, int timeout_ms, const std::string& unix_socket_path) {
+            return new MultiplexClient(host, port, static_cast<size_t>(num_connections), timeout_ms, unix_socket_path);
+        }),
+             py::arg("host") = "127.0.0.1",
+             py::arg("port") = 6379,
+             py::arg("num_connections") = 1,
+             py::arg("timeout_ms") = 200,
+             py::arg("unix_socket_path") = "",
+             "Initialize multiplexed client: one writer thread per connection "
+             "coalesces concurrent requests into pipelined batches, so a "
+             "whole process shares one or two sockets to Redis.")
+        .def("ping", &MultiplexClient::ping,
+             py::call_guard<py::gil_scoped_release>(),
+             "Thread-safe PING")
+        .def("load_script", &MultiplexClient::load_script,
+             py::call_guard<py::gil_scoped_release>(),
+             "Cache Lua script on Redis. Returns SHA1.")
+        .def("eval_script", &MultiplexClient::eval_script,
+             py::arg("script_sha"),
+             py::arg("script_content"),
+             py::arg("keys"),
+             py::arg("args"),
+             py::arg("key_prefix") = "",
+             py::call_guard<py::gil_scoped_release>(),
+             "Execute with automatic fallback (EVALSHA -> SCRIPT LOAD -> EVALSHA). "
+             "Concurrent calls from all threads are coalesced into pipelined "
+             "batches by the lane writer.");
+
+    py::class_<ClusterClient>(m, "ClusterClient")
+        .def(py::init([](const std::string& seed_nodes, int pool_size_per_node, int timeout_ms) {
+            return new ClusterClient(seed_nodes, static_cast<size_t>(pool_size_per_node), timeout_ms);
+        }),
+             py::arg("seed_nodes"),
+             py::arg("pool_size_per_node") = 2,
+             py::arg("timeout_ms") = 200,
+             "Initialize Redis Cluster client. seed_nodes is \"host:port,host:port,...\"; "
+             "the full topology is discovered via CLUSTER SLOTS.")
+        .def("ping", &ClusterClient::ping,
+             py::call_guard<py::gil_scoped_release>(),
+             "Thread-safe PING against any reachable node.")
+        .def("load_script", &ClusterClient::load_script,
+             py::call_guard<py::gil_scoped_release>(),
+             "Cache Lua script on every known master. Returns SHA1.")
+        .def("eval_script", &ClusterClient::eval_script,
+             py::arg("script_sha"),
+             py::arg("script_content"),
+             py::arg("keys"),
+             py::arg("args"),
+             py::arg("key_prefix") = "",
+             py::call_guard<py::gil_scoped_release>(),
+             "Execute on the node owning the key's hash slot, following MOVED/ASK "
+             "redirects. NOSCRIPT triggers a cluster-wide script reload.");
+
+    py::class_<LocalLimiter>(m, "LocalLimiter")
+        .def(py::init([](int max_keys_per_shard) {
+            return new LocalLimiter(max_keys_per_shard < 1 ? 1 : static_cast<size_t>(max_keys_per_shard));
+        }),
+             py::arg("max_keys_per_shard") = 65536,
+             "Initialize the embedded in-memory rate-limit engine (no Redis).")
+        .def("check_gcra", &LocalLimiter::check_gcra,
+             py::arg("key"),
+             py::arg("emission_interval_ms"),
+             py::arg("delay_tolerance_ms"),
+             py::arg("now_ms"),
+             py::call_guard<py::gil_scoped_release>(),
+             "GCRA check with the same semantics and result shape as gcra.lua.")
+        .def("check_token_bucket", &LocalLimiter::check_token_bucket,
+             py::arg("key"),
+             py::arg("capacity"),
+             py::arg("refill_time_ms"),
+             py::arg("now_ms"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Token bucket check with the same semantics and result shape as token_bucket.lua.");
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Lock-free metrics primitives for the C++ core.
+//
+// Counters are cache-line padded so two threads bumping different counters
+// never bounce the same line, and histograms use the HDR-style layout from
+// the load generator (power-of-two buckets split into linear sub-buckets,
+// ~3% value error) with relaxed atomic cells. Recording is one or two
+// relaxed RMWs; snapshotting is plain relaxed loads, so a scraper never
+// blocks the hot path.
+
+namespace flux {
+
+// One counter alone on its cache line.
+struct alignas(64) PaddedCounter {
+    std::atomic<uint64_t> value{0};
+
+    void inc(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t load() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Fixed-bucket latency histogram, values in microseconds.
+class AtomicHistogram {
+public:
+    void record(uint64_t us) {
+        buckets[index_for(us)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        // Racy max is fine: metrics, not accounting.
+        uint64_t prev = max_us.load(std::memory_order_relaxed);
+        while (us > prev &&
+               !max_us.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t total_count() const { return count.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_us.load(std::memory_order_relaxed); }
+
+    // Value at quantile q in [0,1], from a relaxed walk of the buckets.
+    // Concurrent recording can skew the result by a few samples, which is
+    // within the bucket error anyway.
+    uint64_t percentile(double q) const {
+        uint64_t total = total_count();
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total));
+        if (rank >= total) rank = total - 1;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen > rank) return upper_edge(i);
+        }
+        return max();
+    }
+
+private:
+    // 2^6 power-of-two ranges x 2^5 linear sub-buckets each.
+    static constexpr size_t kSubBucketBits = 5;
+    static constexpr size_t kRanges = 64 - kSubBucketBits;
+    static constexpr size_t kBucketCount = kRanges << kSubBucketBits;
+
+    static size_t index_for(uint64_t us) {
+        if (us < (1ULL << kSubBucketBits)) return static_cast<size_t>(us);
+        int msb = 63 - __builtin_clzll(us);
+        size_t range = static_cast<size_t>(msb) - kSubBucketBits + 1;
+        size_t sub = (us >> (msb - static_cast<int>(kSubBucketBits))) &
+                     ((1ULL << kSubBucketBits) - 1);
+        size_t idx = (range << kSubBucketBits) + sub;
+        return idx < kBucketCount ? idx : kBucketCount - 1;
+    }
+
+    static uint64_t upper_edge(size_t idx) {
+        size_t range = idx >> kSubBucketBits;
+        uint64_t sub = (idx & ((1ULL << kSubBucketBits) - 1)) + 1;
+        if (range == 0) return sub;
+        return ((1ULL << kSubBucketBits) + sub) << (range - 1);
+    }
+
+    std::atomic<uint64_t> buckets[kBucketCount] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> max_us{0};
+};
+
+} // namespace flux
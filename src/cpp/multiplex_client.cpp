@@ -0,0 +1,291 @@
+#include "multiplex_client.hpp"
+#include "eval_util.hpp"
+#include <fmt/core.h>
+#include <chrono>
+#ifdef _WIN32
+  #include <winsock2.h>
+#else
+  #include <sys/socket.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+#endif
+
+using flux::parse_eval_reply;
+
+// ============================================================================
+// MultiplexClient Implementation
+// ============================================================================
+
+MultiplexClient::MultiplexClient(std::string host, int port, size_t num_connections,
+                                 int timeout_ms, std::string unix_socket_path)
+    : host(host), port(port), timeout_ms(timeout_ms),
+      unix_socket_path(unix_socket_path),
+      key_cache(10000) {
+
+    if (num_connections == 0) num_connections = 1;
+
+    lanes.reserve(num_connections);
+    for (size_t i = 0; i < num_connections; i++) {
+        lanes.push_back(std::make_unique<Lane>());
+    }
+    // Threads start after the vector is fully built so writer_loop never sees
+    // a resizing container.
+    for (auto& lane : lanes) {
+        lane->writer = std::thread(&MultiplexClient::writer_loop, this, std::ref(*lane));
+    }
+
+    spdlog::debug("MultiplexClient: {} lane(s) started", num_connections);
+}
+
+MultiplexClient::~MultiplexClient() {
+    stop_requested = true;
+    for (auto& lane : lanes) {
+        lane->cv.notify_all();
+    }
+    // Writers drain their queues (failing what they cannot send) before
+    // exiting, so every outstanding future is settled by the time we join.
+    for (auto& lane : lanes) {
+        if (lane->writer.joinable()) lane->writer.join();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Submission (any thread)
+// ----------------------------------------------------------------------------
+
+void MultiplexClient::submit(std::unique_ptr<PendingCommand> cmd) {
+    if (stop_requested) {
+        fail(*cmd, std::make_exception_ptr(std::runtime_error("Client is shutting down")));
+        return;
+    }
+
+    Lane& lane = *lanes[next_lane.fetch_add(1, std::memory_order_relaxed) % lanes.size()];
+    {
+        std::lock_guard<std::mutex> lock(lane.mtx);
+        lane.queue.push_back(std::move(cmd));
+    }
+    lane.cv.notify_one();
+}
+
+std::future<std::string> MultiplexClient::submit_ping() {
+    auto cmd = std::make_unique<PendingCommand>();
+    cmd->wants_string = true;
+    cmd->argv = {"PING"};
+    auto future = cmd->str_promise.get_future();
+    submit(std::move(cmd));
+    return future;
+}
+
+std::future<std::string> MultiplexClient::submit_script_load(const std::string& script_content) {
+    auto cmd = std::make_unique<PendingCommand>();
+    cmd->wants_string = true;
+    cmd->argv = {"SCRIPT", "LOAD", script_content};
+    auto future = cmd->str_promise.get_future();
+    submit(std::move(cmd));
+    return future;
+}
+
+std::future<std::vector<long long>> MultiplexClient::submit_eval_sha(
+    const std::string& script_sha,
+    const std::vector<std::string>& keys,
+    const std::vector<long long>& args
+) {
+    auto cmd = std::make_unique<PendingCommand>();
+    cmd->argv.reserve(3 + keys.size() + args.size());
+    cmd->argv.push_back("EVALSHA");
+    cmd->argv.push_back(script_sha);
+    cmd->argv.push_back(std::to_string(keys.size()));
+    for (const auto& key : keys) cmd->argv.push_back(key);
+    for (long long arg : args) cmd->argv.push_back(std::to_string(arg));
+
+    auto future = cmd->int_promise.get_future();
+    submit(std::move(cmd));
+    return future;
+}
+
+// ----------------------------------------------------------------------------
+// Blocking conveniences
+// ----------------------------------------------------------------------------
+
+std::string MultiplexClient::ping() {
+    return submit_ping().get();
+}
+
+std::string MultiplexClient::load_script(const std::string& script_content) {
+    return submit_script_load(script_content).get();
+}
+
+std::vector<long long> MultiplexClient::eval_script(
+    const std::string& script_sha,
+    const std::string& script_content,
+    const std::vector<std::string>& raw_keys,
+    const std::vector<long long>& args,
+    const std::string& key_prefix
+) {
+    // Hash keys inside C++, same as RedisClient::eval_script
+    std::vector<std::string> hashed_keys;
+    hashed_keys.reserve(raw_keys.size());
+    for (const auto& k : raw_keys) {
+        hashed_keys.push_back(key_cache.get_or_compute(k, key_prefix));
+    }
+
+    try {
+        return submit_eval_sha(script_sha, hashed_keys, args).get();
+    } catch (const std::runtime_error& e) {
+        std::string err = e.what();
+        if (err == "NOSCRIPT") {
+            spdlog::warn("NOSCRIPT received, re-loading script...");
+            submit_script_load(script_content).get();
+            return submit_eval_sha(script_sha, hashed_keys, args).get();
+        }
+        throw;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Writer (one dedicated thread per lane)
+// ----------------------------------------------------------------------------
+
+redisContext* MultiplexClient::connect() {
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    redisContext* ctx;
+    if (!unix_socket_path.empty()) {
+        ctx = redisConnectUnixWithTimeout(unix_socket_path.c_str(), timeout);
+    } else {
+        ctx = redisConnectWithTimeout(host.c_str(), port, timeout);
+    }
+
+    if (ctx == nullptr || ctx->err) {
+        std::string err = ctx ? ctx->errstr : "Allocation failure";
+        if (ctx) redisFree(ctx);
+        throw std::runtime_error(fmt::format("Redis Connection Failed: {}", err));
+    }
+
+    if (unix_socket_path.empty()) {
+        // The lane carries many small pipelined writes; Nagle would hold the
+        // tail of a batch back waiting to coalesce with the next one.
+        int flag = 1;
+        if (setsockopt(ctx->fd, IPPROTO_TCP, TCP_NODELAY,
+                       reinterpret_cast<const char*>(&flag), sizeof(flag)) != 0) {
+            spdlog::warn("Failed to set TCP_NODELAY on Redis connection");
+        }
+        if (redisEnableKeepAlive(ctx) != REDIS_OK) {
+            spdlog::warn("Failed to enable TCP keepalive on Redis connection");
+        }
+    }
+
+    redisSetTimeout(ctx, timeout);
+    return ctx;
+}
+
+void MultiplexClient::fail(PendingCommand& cmd, const std::exception_ptr& err) {
+    if (cmd.wants_string) cmd.str_promise.set_exception(err);
+    else cmd.int_promise.set_exception(err);
+}
+
+void MultiplexClient::fulfill(PendingCommand& cmd, redisReply* reply) {
+    if (cmd.wants_string) {
+        if (reply && (reply->type == REDIS_REPLY_STATUS || reply->type == REDIS_REPLY_STRING)) {
+            cmd.str_promise.set_value(std::string(reply->str, reply->len));
+        } else if (reply && reply->type == REDIS_REPLY_ERROR) {
+            fail(cmd, std::make_exception_ptr(std::runtime_error(
+                "Redis error: " + std::string(reply->str, reply->len))));
+        } else {
+            fail(cmd, std::make_exception_ptr(std::runtime_error(
+                "Unexpected Redis reply type")));
+        }
+        if (reply) freeReplyObject(reply);
+        return;
+    }
+
+    // parse_eval_reply takes ownership of the reply and throws for NOSCRIPT
+    // and Lua errors; forward either outcome into the promise.
+    try {
+        cmd.int_promise.set_value(parse_eval_reply(reply));
+    } catch (...) {
+        cmd.int_promise.set_exception(std::current_exception());
+    }
+}
+
+void MultiplexClient::writer_loop(Lane& lane) {
+    std::deque<std::unique_ptr<PendingCommand>> batch;
+
+    while (true) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(lane.mtx);
+            lane.cv.wait(lock, [&] { return stop_requested || !lane.queue.empty(); });
+            // On shutdown keep draining until the queue is empty so every
+            // future gets settled.
+            if (lane.queue.empty()) break;
+            batch.swap(lane.queue);
+        }
+
+        // Reconnect off the callers' path. A hard-down Redis fails the whole
+        // batch immediately (callers see the error, not a stall) and the
+        // short pause stops the writer from spinning on connect attempts.
+        if (lane.ctx == nullptr) {
+            try {
+                lane.ctx = connect();
+            } catch (const std::exception& e) {
+                auto err = std::make_exception_ptr(
+                    std::runtime_error(std::string("Redis unavailable: ") + e.what()));
+                for (auto& cmd : batch) fail(*cmd, err);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                continue;
+            }
+        }
+
+        // Append phase: every command queued since the last pass goes into
+        // the output buffer, then one flush writes the whole batch. This is
+        // where the multiplexing wins: N concurrent callers cost one
+        // syscall and one RTT instead of N.
+        size_t appended = 0;
+        for (auto& cmd : batch) {
+            std::vector<const char*> argv;
+            std::vector<size_t> argvlen;
+            argv.reserve(cmd->argv.size());
+            argvlen.reserve(cmd->argv.size());
+            for (const auto& part : cmd->argv) {
+                argv.push_back(part.c_str());
+                argvlen.push_back(part.size());
+            }
+            if (redisAppendCommandArgv(lane.ctx, static_cast<int>(argv.size()),
+                                       argv.data(), argvlen.data()) != REDIS_OK) {
+                break;
+            }
+            appended++;
+        }
+
+        // Read phase: replies come back in submission order, so the i-th
+        // reply settles the i-th command.
+        size_t settled = 0;
+        bool broken = false;
+        for (; settled < appended; settled++) {
+            void* reply = nullptr;
+            if (redisGetReply(lane.ctx, &reply) != REDIS_OK) {
+                broken = true;
+                break;
+            }
+            fulfill(*batch[settled], (redisReply*)reply);
+        }
+
+        if (broken || appended < batch.size()) {
+            auto err = std::make_exception_ptr(
+                std::runtime_error("Redis command failed (Network error?)"));
+            for (size_t i = settled; i < batch.size(); i++) fail(*batch[i], err);
+            spdlog::warn("MultiplexClient: lane connection lost ({}), reconnecting",
+                         lane.ctx->err ? lane.ctx->errstr : "append failed");
+            redisFree(lane.ctx);
+            lane.ctx = nullptr;
+        }
+    }
+
+    if (lane.ctx) {
+        redisFree(lane.ctx);
+        lane.ctx = nullptr;
+    }
+}
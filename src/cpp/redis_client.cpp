@@ -1,35 +1,128 @@
 #include "redis_client.hpp"
+#include "token_lease.hpp"
+#include "shm_cache.hpp"
+#include "tracking_cache.hpp"
+#include "analytics_batcher.hpp"
+#include "eval_util.hpp"
 #include <fmt/core.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #ifdef _WIN32
   #include <winsock2.h>
+#else
+  #include <sys/socket.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
 #endif
+#include <algorithm>
 #include <iostream>
 
 // ============================================================================
 // RedisClient Implementation
 // ============================================================================
 
-RedisClient::RedisClient(std::string host, int port, size_t pool_size, int timeout_ms, std::string log_path, bool enable_console_logging) 
-    : host(host), port(port), pool_size(pool_size), timeout_ms(timeout_ms) {
-    
+RedisClient::RedisClient(std::string host, int port, size_t pool_size, int timeout_ms, std::string log_path, bool enable_console_logging,
+                         bool enable_denial_cache, size_t key_cache_size,
+                         const std::string& shm_cache_name,
+                         const std::string& unix_socket_path,
+                         bool circuit_fail_open,
+                         size_t min_pool_size,
+                         bool thread_affinity)
+    : host(host), port(port), timeout_ms(timeout_ms),
+      unix_socket_path(unix_socket_path),
+      connection_pool(pool_size), pool_size(pool_size),
+      thread_affinity(thread_affinity),
+      denial_cache_enabled(enable_denial_cache),
+      circuit_fail_open(circuit_fail_open),
+      key_cache(key_cache_size) {
+
     setup_logging(log_path, enable_console_logging);
     if (enable_console_logging) {
         spdlog::debug("Initializing RedisClient with pool_size={}", pool_size);
     }
 
-    for (size_t i = 0; i < pool_size; i++) {
-        connection_pool.push(create_connection());
+    if (thread_affinity) {
+        affinity_registry = std::make_shared<AffinityRegistry>();
+        affinity_registry->client = this;
+    }
+
+    if (!shm_cache_name.empty()) {
+        try {
+            shm_cache = std::make_unique<ShmDecisionCache>(shm_cache_name);
+        } catch (const std::exception& e) {
+            // The cache is an optimization; run without it rather than fail.
+            spdlog::warn("Shared-memory cache unavailable: {}", e.what());
+        }
     }
+
+    // Warm the pool with parallel connects: serial warm-up costs one full
+    // TCP connect per slot, which adds seconds to worker boot with a large
+    // pool and a remote Redis. We block only until min_pool_size connections
+    // are ready (0 = the whole pool); the maintenance thread grows the pool
+    // toward pool_size in the background.
+    size_t warm_target = (min_pool_size == 0 || min_pool_size > pool_size)
+                             ? pool_size : min_pool_size;
+    if (warm_target > 0) {
+        std::atomic<size_t> next{0};
+        std::mutex error_mutex;
+        std::exception_ptr first_error;
+
+        size_t workers = std::min<size_t>(warm_target, 8);
+        std::vector<std::thread> warmers;
+        warmers.reserve(workers);
+        for (size_t w = 0; w < workers; w++) {
+            warmers.emplace_back([&] {
+                while (next.fetch_add(1, std::memory_order_relaxed) < warm_target) {
+                    try {
+                        connection_pool.try_push(create_connection());
+                        live_connections.fetch_add(1, std::memory_order_relaxed);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!first_error) first_error = std::current_exception();
+                    }
+                }
+            });
+        }
+        for (auto& t : warmers) t.join();
+
+        // Partial warm-up is fine (maintenance replenishes the rest), but a
+        // completely unreachable Redis should still fail construction fast.
+        if (live_connections.load() == 0 && first_error) {
+            std::rethrow_exception(first_error);
+        }
+        if (live_connections.load() < warm_target) {
+            spdlog::warn("Pool warm-up incomplete: {}/{} connections ready",
+                         live_connections.load(), warm_target);
+        }
+    }
+
+    maintenance_thread = std::thread(&RedisClient::maintenance_loop, this);
 }
 
 RedisClient::~RedisClient() {
-    std::lock_guard<std::mutex> lock(pool_mutex);
+    // Join the lease refresher before draining the pool it evals through.
+    lease_manager.reset();
+
     shutting_down = true;
-    while (!connection_pool.empty()) {
-        redisFree(connection_pool.front());
-        connection_pool.pop();
+    if (maintenance_thread.joinable()) maintenance_thread.join();
+    pool_cv.notify_all();
+
+    // Detach from the affinity registry before freeing anything: late thread
+    // exits see client == nullptr and free their own parked connection.
+    if (affinity_registry) {
+        std::lock_guard<std::mutex> lock(affinity_registry->mtx);
+        affinity_registry->client = nullptr;
+        for (auto& slot : affinity_registry->slots) {
+            redisContext* c = slot->ctx.exchange(nullptr, std::memory_order_acquire);
+            if (c) redisFree(c);
+        }
+        affinity_registry->slots.clear();
+    }
+
+    redisContext* ctx;
+    while (connection_pool.try_pop(ctx)) {
+        redisFree(ctx);
     }
 }
 
@@ -42,26 +135,155 @@ redisContext* RedisClient::create_connection() {
     timeout.tv_sec = timeout_ms / 1000;
     timeout.tv_usec = (timeout_ms % 1000) * 1000;
 
-    redisContext* ctx = redisConnectWithTimeout(host.c_str(), port, timeout);
-    
+    redisContext* ctx;
+    if (!unix_socket_path.empty()) {
+        // Colocated Redis: a Unix domain socket skips the TCP/IP stack
+        // entirely, roughly halving the per-check round trip.
+        ctx = redisConnectUnixWithTimeout(unix_socket_path.c_str(), timeout);
+    } else {
+        ctx = redisConnectWithTimeout(host.c_str(), port, timeout);
+    }
+
     if (ctx == nullptr || ctx->err) {
         std::string err = ctx ? ctx->errstr : "Allocation failure";
         if (ctx) redisFree(ctx);
         throw std::runtime_error(fmt::format("Redis Connection Failed: {}", err));
     }
+
+    if (unix_socket_path.empty()) {
+        // Rate-limit traffic is many small request/response pairs; with Nagle
+        // enabled the kernel can hold a request back waiting to coalesce,
+        // which shows up as p99 spikes. Keepalive evicts silently dead peers
+        // (NAT timeouts, failovers) instead of stalling a pooled connection.
+        int flag = 1;
+        if (setsockopt(ctx->fd, IPPROTO_TCP, TCP_NODELAY,
+                       reinterpret_cast<const char*>(&flag), sizeof(flag)) != 0) {
+            spdlog::warn("Failed to set TCP_NODELAY on Redis connection");
+        }
+        if (redisEnableKeepAlive(ctx) != REDIS_OK) {
+            spdlog::warn("Failed to enable TCP keepalive on Redis connection");
+        }
+    }
+
+    // Bound in-flight commands too, not just the connect: without this a
+    // stalled Redis can hold a request past any SLO.
+    redisSetTimeout(ctx, timeout);
+
     return ctx;
 }
 
+void RedisClient::maintenance_loop() {
+    // All connection upkeep happens here, never on a request thread:
+    //  - while the circuit is open, PING on a fresh connection every 200ms
+    //    and close the circuit as soon as Redis answers again;
+    //  - while closed, replace connections evicted by ConnectionGuard so a
+    //    request thread never pays connection-establishment cost inline;
+    //  - every few seconds, PING one idle connection so silently dead peers
+    //    (failovers, NAT timeouts) are evicted before a request finds them.
+    constexpr int kHealthCheckEveryTicks = 25; // 25 * 200ms = 5s cadence
+    int tick = 0;
+
+    while (!shutting_down) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (shutting_down) break;
+        tick++;
+
+        if (circuit.is_open()) {
+            try {
+                redisContext* ctx = create_connection();
+                redisReply* reply = (redisReply*)redisCommand(ctx, "PING");
+                bool ok = reply && reply->type == REDIS_REPLY_STATUS;
+                if (reply) freeReplyObject(reply);
+
+                if (ok) {
+                    // Keep the probe connection: it is the first known-good
+                    // one after the outage.
+                    if (connection_pool.try_push(ctx)) {
+                        live_connections.fetch_add(1, std::memory_order_relaxed);
+                        pool_cv.notify_one();
+                    } else {
+                        redisFree(ctx);
+                    }
+                    circuit.close();
+                    spdlog::info("Circuit closed: Redis reachable again");
+                } else {
+                    redisFree(ctx);
+                }
+            } catch (const std::exception&) {
+                // Still down; probe again next tick.
+            }
+            continue;
+        }
+
+        // Replenish connections evicted after errors. live_connections <
+        // pool_size guarantees ring capacity for the push.
+        while (live_connections.load(std::memory_order_relaxed) < pool_size) {
+            try {
+                redisContext* ctx = create_connection();
+                connection_pool.try_push(ctx);
+                live_connections.fetch_add(1, std::memory_order_relaxed);
+                pool_cv.notify_one();
+                SPDLOG_DEBUG("Replenished evicted pool connection");
+            } catch (const std::exception& e) {
+                // Can't reconnect right now; request threads will trip the
+                // breaker if Redis is really gone. Try again next tick.
+                spdlog::warn("Pool replenish failed: {}", e.what());
+                break;
+            }
+        }
+
+        // Health-check one idle connection per cadence window. Borrowing a
+        // single connection at a time keeps the pool nearly full for request
+        // threads; eviction is picked up by the replenish pass above.
+        // Sticky connections whose thread went quiet go back to the shared
+        // ring so waiting threads are not starved by parked capacity.
+        if (thread_affinity && tick % kHealthCheckEveryTicks == 0) {
+            reclaim_idle_affinity_connections();
+        }
+
+        // Hot-key upkeep shares the health-check cadence: halve the sketch
+        // (turning it into a ~5s sliding window) and pull drifted shards
+        // back to the mean.
+        if (sharder && tick % kHealthCheckEveryTicks == 0) {
+            sharder->sketch.decay();
+            rebalance_hot_keys();
+        }
+
+        if (tick % kHealthCheckEveryTicks == 0) {
+            redisContext* ctx;
+            if (connection_pool.try_pop(ctx)) {
+                redisReply* reply = (redisReply*)redisCommand(ctx, "PING");
+                bool ok = reply && reply->type == REDIS_REPLY_STATUS;
+                if (reply) freeReplyObject(reply);
+
+                if (ok) {
+                    connection_pool.try_push(ctx);
+                    pool_cv.notify_one();
+                } else {
+                    spdlog::warn("Evicting unhealthy idle connection");
+                    redisFree(ctx);
+                    live_connections.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+}
+
 void RedisClient::setup_logging(const std::string& log_path, bool enable_console_logging) {
     if (spdlog::get("flux")) {
         spdlog::drop("flux");
     }
 
     try {
+        // Ring-buffer thread pool: hot-path log calls only format into the
+        // ring; the file write happens on the logging thread. On overflow the
+        // oldest entries are dropped rather than blocking a rate-limit check.
+        spdlog::init_thread_pool(8192, 1);
+
         std::vector<spdlog::sink_ptr> sinks;
-        
+
         // Always add file sink
-        auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(log_path, false); 
+        auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(log_path, false);
         sinks.push_back(file_sink);
 
         // Conditionally add console sink
@@ -69,13 +291,18 @@ void RedisClient::setup_logging(const std::string& log_path, bool enable_console
             auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
             sinks.push_back(console_sink);
         }
-        
-        auto logger = std::make_shared<spdlog::logger>("flux", sinks.begin(), sinks.end());
-        
+
+        auto logger = std::make_shared<spdlog::async_logger>(
+            "flux", sinks.begin(), sinks.end(), spdlog::thread_pool(),
+            spdlog::async_overflow_policy::overrun_oldest);
+
         spdlog::set_default_logger(logger);
         spdlog::set_level(spdlog::level::debug);
-        spdlog::flush_on(spdlog::level::debug);
-        
+        // Only errors force a flush; everything else rides the periodic one.
+        // flush_on(debug) used to cost a synchronous write per check.
+        spdlog::flush_on(spdlog::level::err);
+        spdlog::flush_every(std::chrono::seconds(3));
+
         if (enable_console_logging) {
             spdlog::info("Flux logging initialized. Writing to console and {}", log_path);
         } else {
@@ -86,26 +313,210 @@ void RedisClient::setup_logging(const std::string& log_path, bool enable_console
     }
 }
 
+// ----------------------------------------------------------------------------
+// Denial Cache
+// ----------------------------------------------------------------------------
+
+long long RedisClient::DenialCache::lookup(const std::string& key) {
+    Shard& shard = shards[std::hash<std::string>{}(key) % kShards];
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.blocked_until.find(key);
+    if (it == shard.blocked_until.end()) return 0;
+
+    if (it->second <= now) {
+        shard.blocked_until.erase(it);
+        return 0;
+    }
+
+    auto remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(it->second - now).count();
+    return (remaining_ms + 999) / 1000; // round up, matching the Lua scripts
+}
+
+void RedisClient::DenialCache::insert(const std::string& key, long long retry_after_s) {
+    if (retry_after_s <= 0) return;
+
+    Shard& shard = shards[std::hash<std::string>{}(key) % kShards];
+    auto now = std::chrono::steady_clock::now();
+    auto deadline = now + std::chrono::seconds(retry_after_s);
+
+    std::lock_guard<std::mutex> lock(shard.mtx);
+
+    // Opportunistic purge: keep the shard bounded during key churn.
+    if (shard.blocked_until.size() >= kMaxEntriesPerShard) {
+        for (auto it = shard.blocked_until.begin(); it != shard.blocked_until.end();) {
+            if (it->second <= now) it = shard.blocked_until.erase(it);
+            else ++it;
+        }
+        // Still full of live denials: drop the new entry rather than grow.
+        if (shard.blocked_until.size() >= kMaxEntriesPerShard) return;
+    }
+
+    shard.blocked_until[key] = deadline;
+}
+
 // ----------------------------------------------------------------------------
 // Connection Guard
 // ----------------------------------------------------------------------------
 
-RedisClient::ConnectionGuard::ConnectionGuard(RedisClient& client) : parent(client) {
-    std::unique_lock<std::mutex> lock(parent.pool_mutex);
-    
-    parent.pool_cv.wait(lock, [&] { 
-        return !parent.connection_pool.empty() || parent.shutting_down; 
-    });
+RedisClient::TlsAffinity& RedisClient::tls_affinity() {
+    static thread_local TlsAffinity tls;
+    return tls;
+}
 
+RedisClient::TlsAffinity::~TlsAffinity() {
+    // Thread exit: free the parked connection rather than reach into pool
+    // structures from an arbitrary teardown context; the maintenance thread
+    // replenishes the pool. The registry outlives the client, so this is
+    // safe no matter which of the two dies first.
+    if (!slot) return;
+    redisContext* c = slot->ctx.exchange(nullptr, std::memory_order_acquire);
+    if (!c) return;
+
+    redisFree(c);
+    std::lock_guard<std::mutex> lock(registry->mtx);
+    if (registry->client) {
+        registry->client->live_connections.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void RedisClient::reclaim_idle_affinity_connections() {
+    constexpr long long kAffinityIdleMs = 5000;
+    long long now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    std::lock_guard<std::mutex> lock(affinity_registry->mtx);
+    for (auto it = affinity_registry->slots.begin();
+         it != affinity_registry->slots.end();) {
+        auto& slot = *it;
+
+        // Slot abandoned (thread exited or rebound): registry holds the last
+        // reference and the parked connection, if any, was already freed.
+        if (slot.use_count() == 1 &&
+            slot->ctx.load(std::memory_order_relaxed) == nullptr) {
+            it = affinity_registry->slots.erase(it);
+            continue;
+        }
+
+        redisContext* c = slot->ctx.load(std::memory_order_relaxed);
+        if (c != nullptr &&
+            now_ms - slot->last_used_ms.load(std::memory_order_relaxed) >= kAffinityIdleMs) {
+            // The owning thread went idle: hand its connection back to the
+            // shared ring. The exchange races fairly with the owner waking
+            // up; whoever wins gets the connection.
+            c = slot->ctx.exchange(nullptr, std::memory_order_acquire);
+            if (c) {
+                if (connection_pool.try_push(c)) {
+                    pool_cv.notify_one();
+                } else {
+                    redisFree(c);
+                    live_connections.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        ++it;
+    }
+}
+
+RedisClient::ConnectionGuard::ConnectionGuard(RedisClient& client, long long wait_budget_ms)
+    : parent(client) {
     if (parent.shutting_down) throw std::runtime_error("Client is shutting down");
 
-    ctx = parent.connection_pool.front();
-    parent.connection_pool.pop();
+    if (parent.thread_affinity) {
+        TlsAffinity& tls = tls_affinity();
+        if (tls.owner != &parent) {
+            // First use on this thread (or the thread switched clients — the
+            // old slot stays registered and is harvested by idle reclaim).
+            auto slot = std::make_shared<AffinitySlot>();
+            {
+                std::lock_guard<std::mutex> lock(parent.affinity_registry->mtx);
+                parent.affinity_registry->slots.push_back(slot);
+            }
+            tls.owner = &parent;
+            tls.registry = parent.affinity_registry;
+            tls.slot = std::move(slot);
+        }
+
+        // Steady state: one TLS load plus one exchange on this thread's own
+        // slot — no shared-state writes.
+        redisContext* sticky = tls.slot->ctx.exchange(nullptr, std::memory_order_acquire);
+        if (sticky) {
+            ctx = sticky;
+            from_affinity = true;
+            parent.metrics.checkout_us.record(0);
+            return;
+        }
+
+        // Empty slot: adopt a connection from the shared ring; checkin parks
+        // it in TLS. If the ring is drained (more threads than connections),
+        // fall through to the shared slow path without going sticky.
+        if (parent.connection_pool.try_pop(ctx)) {
+            from_affinity = true;
+            parent.metrics.checkout_us.record(0);
+            return;
+        }
+    }
+
+    // Fast path: grab an idle connection straight off the lock-free ring.
+    // Recorded as a zero-wait checkout without touching the clock.
+    if (parent.connection_pool.try_pop(ctx)) {
+        parent.metrics.checkout_us.record(0);
+        return;
+    }
+
+    // Slow path: the pool is drained, park on the condvar. The short wait
+    // bound covers the race where a connection is returned between our failed
+    // try_pop and the wait: we re-poll the ring on every wakeup.
+    parent.metrics.pool_waits.inc();
+    auto wait_start = std::chrono::steady_clock::now();
+    // A caller's deadline budget covers checkout too: give up once it is
+    // spent instead of parking on the condvar for as long as the pool stays
+    // drained.
+    auto wait_deadline = wait_start + std::chrono::milliseconds(wait_budget_ms);
+
+    std::unique_lock<std::mutex> lock(parent.pool_mutex);
+    while (!parent.connection_pool.try_pop(ctx)) {
+        if (parent.shutting_down) throw std::runtime_error("Client is shutting down");
+        if (wait_budget_ms > 0 && std::chrono::steady_clock::now() >= wait_deadline) {
+            throw std::runtime_error("Deadline exceeded");
+        }
+        parent.pool_cv.wait_for(lock, std::chrono::milliseconds(1));
+    }
+
+    parent.metrics.checkout_us.record(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - wait_start).count());
 }
 
 RedisClient::ConnectionGuard::~ConnectionGuard() {
-    std::lock_guard<std::mutex> lock(parent.pool_mutex);
-    parent.connection_pool.push(ctx);
+    // hiredis sets ctx->err on any I/O error or timeout and the context is
+    // dead from then on: returning it would hand the next caller a corpse
+    // that costs a full timeout to discover. Evict it instead; the
+    // maintenance thread creates a replacement off the request path.
+    if (ctx->err) {
+        SPDLOG_DEBUG("Evicting broken connection (err={}): {}", ctx->err, ctx->errstr);
+        redisFree(ctx);
+        parent.live_connections.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Affinity checkin: park in this thread's slot so the next check here
+    // is a TLS hit. Idle reclaim returns it to the ring if the thread stops
+    // checking.
+    if (from_affinity) {
+        TlsAffinity& tls = tls_affinity();
+        tls.slot->last_used_ms.store(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count(),
+            std::memory_order_relaxed);
+        tls.slot->ctx.store(ctx, std::memory_order_release);
+        return;
+    }
+
+    // Capacity equals pool_size, so returning a checked-out connection
+    // cannot fail.
+    parent.connection_pool.try_push(ctx);
     parent.pool_cv.notify_one();
 }
 
@@ -114,7 +525,7 @@ RedisClient::ConnectionGuard::~ConnectionGuard() {
 // ----------------------------------------------------------------------------
 
 std::string RedisClient::ping() {
-    spdlog::debug("Executing PING command");
+    SPDLOG_DEBUG("Executing PING command");
     return execute_with_retry([this](redisContext* ctx) -> std::string {
         redisReply* reply = (redisReply*)redisCommand(ctx, "PING");
         
@@ -132,7 +543,7 @@ std::string RedisClient::ping() {
 }
 
 std::string RedisClient::load_script(const std::string& script_content) {
-    spdlog::debug("load_script: content_len={}", script_content.size());
+    SPDLOG_DEBUG("load_script: content_len={}", script_content.size());
 
     return execute_with_retry([&](redisContext* ctx) -> std::string {
         redisReply* reply = (redisReply*)redisCommand(ctx, "SCRIPT LOAD %s", script_content.c_str());
@@ -144,7 +555,7 @@ std::string RedisClient::load_script(const std::string& script_content) {
         std::string sha;
         if (reply->type == REDIS_REPLY_STRING || reply->type == REDIS_REPLY_STATUS) {
             sha = reply->str;
-            spdlog::debug("load_script: Cached successfully. SHA={}", sha);
+            SPDLOG_DEBUG("load_script: Cached successfully. SHA={}", sha);
         } else if (reply->type == REDIS_REPLY_ERROR) {
             std::string error = reply->str;
             freeReplyObject(reply);
@@ -159,88 +570,133 @@ std::string RedisClient::load_script(const std::string& script_content) {
     });
 }
 
+// argv marshalling and reply parsing live in eval_util.hpp so the cluster
+// client can share them.
+using flux::EvalshaArgvBuilder;
+using flux::parse_eval_reply;
+
+std::string RedisClient::register_script(const std::string& name, const std::string& content) {
+    // SCRIPT LOAD is server-side and idempotent; the sha it returns is what
+    // every pooled connection will EVALSHA against.
+    auto entry = std::make_shared<RegisteredScript>();
+    entry->content = content;
+    entry->sha = load_script(content);
+
+    spdlog::info("register_script: \"{}\" -> {}", name, entry->sha);
+
+    std::lock_guard<std::mutex> lock(script_registry_mutex);
+    script_registry[name] = std::move(entry);
+    return script_registry[name]->sha;
+}
+
+std::vector<long long> RedisClient::eval_by_name(
+    const std::string& name,
+    const std::vector<std::string>& keys,
+    const std::vector<long long>& args,
+    const std::string& key_prefix,
+    int deadline_ms
+) {
+    std::shared_ptr<const RegisteredScript> entry;
+    {
+        std::lock_guard<std::mutex> lock(script_registry_mutex);
+        auto it = script_registry.find(name);
+        if (it != script_registry.end()) entry = it->second;
+    }
+    if (!entry) {
+        throw std::runtime_error("Unknown script \"" + name + "\" (call register_script first)");
+    }
+    return eval_script(entry->sha, entry->content, keys, args, key_prefix, deadline_ms);
+}
+
 std::vector<long long> RedisClient::eval_sha(
     const std::string& script_sha,
     const std::vector<std::string>& keys,
-    const std::vector<long long>& args
+    const std::vector<long long>& args,
+    int deadline_ms
 ) {
-    spdlog::debug("eval_sha: keys={}, args={}, sha={}", keys.size(), args.size(), script_sha);
+    SPDLOG_DEBUG("eval_sha: keys={}, args={}, sha={}", keys.size(), args.size(), script_sha);
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto result = execute_with_retry([&](redisContext* ctx) -> std::vector<long long> {
+        EvalshaArgvBuilder argv(script_sha, keys, args);
 
-    return execute_with_retry([&](redisContext* ctx) -> std::vector<long long> {
-        std::vector<const char*> argv;
-        std::vector<size_t> argvlen;
-        std::vector<std::string> arg_strings;
-        
-        argv.push_back("EVALSHA");
-        argvlen.push_back(7);
-        
-        argv.push_back(script_sha.c_str());
-        argvlen.push_back(script_sha.size());
-        
-        arg_strings.push_back(std::to_string(keys.size()));
-        argv.push_back(arg_strings.back().c_str());
-        argvlen.push_back(arg_strings.back().size());
-        
-        for (const auto& key : keys) {
-            argv.push_back(key.c_str());
-            argvlen.push_back(key.size());
-        }
-        
-        for (long long arg : args) {
-            arg_strings.push_back(std::to_string(arg));
-            argv.push_back(arg_strings.back().c_str());
-            argvlen.push_back(arg_strings.back().size());
-        }
-        
         redisReply* reply = (redisReply*)redisCommandArgv(
-            ctx, 
-            static_cast<int>(argv.size()), 
-            argv.data(), 
-            argvlen.data()
+            ctx,
+            argv.argc(),
+            argv.argv(),
+            argv.argvlen()
         );
 
-        if (!reply) {
-            throw std::runtime_error("Redis EVALSHA command failed (Network error?)");
+        return parse_eval_reply(reply);
+    }, 3, 50, deadline_ms);
+
+    metrics.eval_us.record(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+
+    return result;
+}
+
+std::vector<std::vector<long long>> RedisClient::eval_sha_batch(
+    const std::string& script_sha,
+    const std::vector<EvalCall>& calls
+) {
+    SPDLOG_DEBUG("eval_sha_batch: calls={}, sha={}", calls.size(), script_sha);
+
+    if (calls.empty()) return {};
+
+    return execute_with_retry([&](redisContext* ctx) -> std::vector<std::vector<long long>> {
+        // Queue every EVALSHA into the output buffer, flush once, then drain
+        // replies in order: one network round trip for the whole batch.
+        for (const auto& call : calls) {
+            EvalshaArgvBuilder argv(script_sha, call.first, call.second);
+
+            if (redisAppendCommandArgv(
+                    ctx,
+                    argv.argc(),
+                    argv.argv(),
+                    argv.argvlen()) != REDIS_OK) {
+                throw std::runtime_error("Redis EVALSHA append failed (Network error?)");
+            }
         }
 
-        if (reply->type == REDIS_REPLY_ERROR && 
-            std::string(reply->str).find("NOSCRIPT") != std::string::npos) {
-            freeReplyObject(reply);
-            throw std::runtime_error("NOSCRIPT");
-        }
-
-        std::vector<long long> result;
-
-        if (reply->type == REDIS_REPLY_ARRAY) {
-            result.reserve(reply->elements);
-            for(size_t i = 0; i < reply->elements; i++) {
-                if(reply->element[i]->type == REDIS_REPLY_INTEGER) {
-                    result.push_back(reply->element[i]->integer);
-                } else if(reply->element[i]->type == REDIS_REPLY_STRING) {
-                     // Try to convert string to long long if needed, or just 0
-                     try {
-                        result.push_back(std::stoll(reply->element[i]->str));
-                     } catch (...) {
-                         result.push_back(0); 
-                     }
-                } else {
-                     result.push_back(0); // Fallback
-                }
+        // Collect all replies before parsing: if one invocation errored we
+        // still have to drain the rest, or the connection desynchronizes.
+        std::vector<redisReply*> replies;
+        replies.reserve(calls.size());
+        bool read_failed = false;
+
+        for (size_t i = 0; i < calls.size(); i++) {
+            void* reply = nullptr;
+            if (redisGetReply(ctx, &reply) != REDIS_OK) {
+                read_failed = true;
+                break;
             }
-        } else if (reply->type == REDIS_REPLY_ERROR) {
-            std::string error = reply->str;
-            freeReplyObject(reply);
-            throw std::runtime_error("Lua error: " + error);
-        } else if (reply->type == REDIS_REPLY_INTEGER) {
-            // Single integer return (shouldn't happen with our scripts but safe to handle)
-            result.push_back(reply->integer);
-        } else {
-            freeReplyObject(reply);
-            throw std::runtime_error("Unexpected reply type");
+            replies.push_back((redisReply*)reply);
         }
 
-        freeReplyObject(reply);
-        return result;
+        std::vector<std::vector<long long>> results;
+        results.reserve(calls.size());
+        std::exception_ptr first_error;
+
+        for (redisReply* reply : replies) {
+            if (first_error) {
+                freeReplyObject(reply);
+                continue;
+            }
+            try {
+                results.push_back(parse_eval_reply(reply)); // takes ownership
+            } catch (...) {
+                first_error = std::current_exception();
+            }
+        }
+
+        if (first_error) std::rethrow_exception(first_error);
+        if (read_failed) {
+            throw std::runtime_error("Redis EVALSHA batch reply failed (Network error?)");
+        }
+
+        return results;
     });
 }
 
@@ -259,25 +715,377 @@ std::vector<long long> RedisClient::eval_script(
     const std::string& script_content,
     const std::vector<std::string>& raw_keys,
     const std::vector<long long>& args,
-    const std::string& key_prefix
+    const std::string& key_prefix,
+    int deadline_ms
 ) {
+    metrics.checks.inc();
+
     // Hash keys inside C++
     std::vector<std::string> hashed_keys;
     hashed_keys.reserve(raw_keys.size());
     
     for (const auto& k : raw_keys) {
-        std::string hashed = sha256(k);
-        hashed_keys.push_back(key_prefix + hashed);
+        hashed_keys.push_back(key_cache.get_or_compute(k, key_prefix));
     }
-    
+
+    // Hot-key fan-out rewrites keys/args before the denial caches, so the
+    // cached verdicts below are per shard.
+    std::vector<long long> scaled_args;
+    const std::vector<long long>* eval_args = &args;
+    if (sharder && !hashed_keys.empty()) {
+        scaled_args = args;
+        apply_hot_key_sharding(hashed_keys, scaled_args);
+        eval_args = &scaled_args;
+    }
+
+    // A key denied with retry_after T stays denied until the deadline, so
+    // repeat offenders are answered in-process with zero network I/O.
+    if (denial_cache_enabled && !hashed_keys.empty()) {
+        long long remaining = denial_cache.lookup(hashed_keys[0]);
+        if (remaining > 0) {
+            SPDLOG_DEBUG("eval_script: denial cache hit, retry_after={}s", remaining);
+            metrics.denies.inc();
+            return {-1, remaining, 0};
+        }
+    }
+
+    // Cross-process layer: a sibling worker on this host may already have
+    // seen this key denied.
+    if (shm_cache && !hashed_keys.empty()) {
+        long long now_epoch_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        long long remaining = shm_cache->lookup_denial(hashed_keys[0], now_epoch_ms);
+        if (remaining > 0) {
+            SPDLOG_DEBUG("eval_script: shm cache hit, retry_after={}s", remaining);
+            metrics.denies.inc();
+            return {-1, remaining, 0};
+        }
+    }
+
+    try {
+        auto result = eval_sha(script_sha, hashed_keys, *eval_args, deadline_ms);
+        if (!result.empty() && result[0] == 0) metrics.allows.inc();
+        else metrics.denies.inc();
+        // Scripts return {-1, retry_after_s, usage} on denial.
+        if (!hashed_keys.empty() && result.size() >= 2) {
+            if (denial_cache_enabled && result[0] == -1) {
+                denial_cache.insert(hashed_keys[0], result[1]);
+            }
+            if (shm_cache) {
+                long long now_epoch_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                if (result[0] == -1) {
+                    shm_cache->publish(hashed_keys[0], false,
+                                       now_epoch_ms + result[1] * 1000, 0);
+                } else {
+                    // Clears any stale denial; value slot is the TAT for GCRA.
+                    shm_cache->publish(hashed_keys[0], true, 0, result[1]);
+                }
+            }
+        }
+        return result;
+    } catch (const CircuitOpenError&) {
+        // Redis is down and the breaker is open: answer in microseconds with
+        // the configured verdict instead of stalling the caller.
+        SPDLOG_DEBUG("eval_script: circuit open, fail-{}", circuit_fail_open ? "open" : "closed");
+        if (circuit_fail_open) {
+            metrics.allows.inc();
+            return {0, 0, 0};
+        }
+        metrics.denies.inc();
+        return {-1, 1, 0}; // deny, suggest retry in 1s
+    } catch (const std::runtime_error& e) {
+        std::string err = e.what();
+        if (err == "NOSCRIPT") {
+            spdlog::warn("NOSCRIPT received, re-loading script...");
+            metrics.noscript_reloads.inc();
+            load_script(script_content);
+            auto result = eval_sha(script_sha, hashed_keys, *eval_args, deadline_ms);
+            if (!result.empty() && result[0] == 0) metrics.allows.inc();
+            else metrics.denies.inc();
+            return result;
+        }
+        throw;
+    }
+}
+
+std::unordered_map<std::string, long long> RedisClient::get_metrics() {
+    // Relaxed loads only: a scrape races with recording, but each value is
+    // individually consistent and that is all a time-series needs.
+    std::unordered_map<std::string, long long> out;
+
+    out["checks"] = static_cast<long long>(metrics.checks.load());
+    out["allows"] = static_cast<long long>(metrics.allows.load());
+    out["denies"] = static_cast<long long>(metrics.denies.load());
+    out["retries"] = static_cast<long long>(metrics.retries.load());
+    out["noscript_reloads"] = static_cast<long long>(metrics.noscript_reloads.load());
+    out["pool_waits"] = static_cast<long long>(metrics.pool_waits.load());
+
+    out["eval_count"] = static_cast<long long>(metrics.eval_us.total_count());
+    out["eval_p50_us"] = static_cast<long long>(metrics.eval_us.percentile(0.50));
+    out["eval_p90_us"] = static_cast<long long>(metrics.eval_us.percentile(0.90));
+    out["eval_p99_us"] = static_cast<long long>(metrics.eval_us.percentile(0.99));
+    out["eval_p999_us"] = static_cast<long long>(metrics.eval_us.percentile(0.999));
+    out["eval_max_us"] = static_cast<long long>(metrics.eval_us.max());
+
+    out["checkout_count"] = static_cast<long long>(metrics.checkout_us.total_count());
+    out["checkout_p50_us"] = static_cast<long long>(metrics.checkout_us.percentile(0.50));
+    out["checkout_p90_us"] = static_cast<long long>(metrics.checkout_us.percentile(0.90));
+    out["checkout_p99_us"] = static_cast<long long>(metrics.checkout_us.percentile(0.99));
+    out["checkout_p999_us"] = static_cast<long long>(metrics.checkout_us.percentile(0.999));
+    out["checkout_max_us"] = static_cast<long long>(metrics.checkout_us.max());
+
+    return out;
+}
+
+std::vector<long long> RedisClient::lease_check(
+    const std::string& script_sha,
+    const std::string& script_content,
+    const std::string& raw_key,
+    long long capacity,
+    long long refill_time_ms,
+    long long batch_size,
+    const std::string& key_prefix
+) {
+    {
+        std::lock_guard<std::mutex> lock(lease_manager_mutex);
+        if (!lease_manager) {
+            lease_manager = std::make_unique<TokenLeaseManager>(*this);
+        }
+    }
+    return lease_manager->check(script_sha, script_content, raw_key,
+                                capacity, refill_time_ms, batch_size, key_prefix);
+}
+
+void RedisClient::enable_analytics(const std::string& stream_key, long long maxlen,
+                                   size_t ring_capacity) {
+    std::lock_guard<std::mutex> lock(analytics_batcher_mutex);
+    analytics_batcher = std::make_unique<AnalyticsBatcher>(
+        host, port, unix_socket_path, timeout_ms, stream_key, maxlen, ring_capacity);
+}
+
+void RedisClient::enable_hot_key_sharding(int num_shards, int hot_threshold,
+                                          const std::string& policy,
+                                          const std::string& rebalance_script) {
+    if (num_shards < 2) {
+        throw std::runtime_error("enable_hot_key_sharding requires num_shards >= 2");
+    }
+    if (sharder) {
+        spdlog::warn("Hot-key sharding already enabled; ignoring repeat call");
+        return;
+    }
+
+    auto s = std::make_unique<HotKeySharder>();
+    s->num_shards = num_shards;
+    s->hot_threshold = hot_threshold < 1 ? 1 : static_cast<uint32_t>(hot_threshold);
+    s->policy = policy;
+    s->rebalance_script = rebalance_script;
+    // Like enable_analytics, this runs at startup before traffic; once set
+    // the pointer never changes, so eval_script reads it unsynchronized.
+    sharder = std::move(s);
+
+    spdlog::info("Hot-key sharding enabled: {} shards, threshold {} ops/window, policy {}",
+                 num_shards, hot_threshold, policy);
+}
+
+void RedisClient::apply_hot_key_sharding(std::vector<std::string>& hashed_keys,
+                                         std::vector<long long>& args) {
+    // Every check counts toward the sketch; the estimate is for the current
+    // decay window, so a key going viral crosses the threshold within
+    // seconds and cools back down a couple of windows after the spike.
+    uint32_t est = sharder->sketch.add(hashed_keys[0]);
+    if (est < sharder->hot_threshold || args.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(sharder->hot_mutex);
+        if (sharder->hot_keys.size() < HotKeySharder::kMaxTrackedHotKeys ||
+            sharder->hot_keys.count(hashed_keys[0])) {
+            sharder->hot_keys.insert(hashed_keys[0]);
+        }
+    }
+
+    const long long n = sharder->num_shards;
+
+    // Scale the policy args so each shard grants rate/N (and burst/N): the
+    // fanned-out limit adds up to the original one.
+    if (sharder->policy == "gcra") {
+        // Emission interval x N gives rate/N per shard, and with the delay
+        // tolerance T unchanged, per-shard burst T/(E*N) = B/N — scaling T
+        // down too would collapse total burst to B/N instead of B.
+        args[0] *= n;
+    } else if (sharder->policy == "token_bucket" || sharder->policy == "leaky_bucket") {
+        args[0] = std::max(1LL, args[0] / n); // capacity per shard
+        if (args.size() > 1) args[1] *= n;    // refill/leak interval per shard
+    } else {
+        args[0] = std::max(1LL, args[0] / n); // generic limit-per-window
+    }
+
+    // Round-robin shard pick spreads one viral key across N Redis keys —
+    // and, with a cluster behind a plain suffix, across N hash slots. FCFS's
+    // companion queue key (index 1) gets the same suffix so each shard stays
+    // self-contained.
+    long long shard = static_cast<long long>(
+        sharder->next_shard.fetch_add(1, std::memory_order_relaxed) % n);
+    std::string suffix = ":s" + std::to_string(shard);
+    for (auto& key : hashed_keys) key += suffix;
+
+    SPDLOG_DEBUG("Hot key fanned out to shard {} (estimate {})", shard, est);
+}
+
+void RedisClient::rebalance_hot_keys() {
+    // Snapshot under the lock, evict keys that cooled off (estimate fell
+    // below half the threshold), and rebalance the rest.
+    std::vector<std::string> hot;
+    {
+        std::lock_guard<std::mutex> lock(sharder->hot_mutex);
+        for (auto it = sharder->hot_keys.begin(); it != sharder->hot_keys.end();) {
+            if (sharder->sketch.estimate(*it) < sharder->hot_threshold / 2) {
+                it = sharder->hot_keys.erase(it);
+            } else {
+                hot.push_back(*it);
+                ++it;
+            }
+        }
+    }
+
+    if (hot.empty() || sharder->rebalance_script.empty()) return;
+
     try {
-        return eval_sha(script_sha, hashed_keys, args);
+        if (sharder->rebalance_sha.empty()) {
+            sharder->rebalance_sha = load_script(sharder->rebalance_script);
+        }
+
+        // Field holding the shard's consumable state; '' means plain string
+        // state (GCRA TAT, fixed-window counter).
+        const char* field = "";
+        if (sharder->policy == "token_bucket") field = "tokens";
+        else if (sharder->policy == "leaky_bucket") field = "level";
+        else if (sharder->policy == "sliding_window") field = "cur";
+
+        for (const auto& base : hot) {
+            std::vector<std::string> parts;
+            parts.reserve(4 + sharder->num_shards);
+            parts.push_back("EVALSHA");
+            parts.push_back(sharder->rebalance_sha);
+            parts.push_back(std::to_string(sharder->num_shards));
+            for (int i = 0; i < sharder->num_shards; i++) {
+                parts.push_back(base + ":s" + std::to_string(i));
+            }
+            parts.push_back(field);
+
+            execute_with_retry([&](redisContext* ctx) -> int {
+                std::vector<const char*> argv;
+                std::vector<size_t> argvlen;
+                argv.reserve(parts.size());
+                argvlen.reserve(parts.size());
+                for (const auto& p : parts) {
+                    argv.push_back(p.c_str());
+                    argvlen.push_back(p.size());
+                }
+                redisReply* reply = (redisReply*)redisCommandArgv(
+                    ctx, static_cast<int>(argv.size()), argv.data(), argvlen.data());
+                if (!reply) throw std::runtime_error("Redis command failed (Network error?)");
+                if (reply->type == REDIS_REPLY_ERROR) {
+                    std::string err(reply->str, reply->len);
+                    freeReplyObject(reply);
+                    // Next window reloads the script (rebalance_sha is
+                    // cleared by the outer catch).
+                    if (err.rfind("NOSCRIPT", 0) == 0) throw std::runtime_error("NOSCRIPT");
+                    throw std::runtime_error("Redis error: " + err);
+                }
+                int moved = (reply->type == REDIS_REPLY_INTEGER)
+                                ? static_cast<int>(reply->integer) : 0;
+                freeReplyObject(reply);
+                return moved;
+            }, 0);
+        }
+    } catch (const std::exception& e) {
+        // Rebalancing is an optimization; shards drift a little longer and
+        // the next window tries again.
+        spdlog::warn("Hot-key rebalance failed: {}", e.what());
+        sharder->rebalance_sha.clear();
+    }
+}
+
+void RedisClient::record_analytics_event(
+    const std::string& hashed_key,
+    const std::string& endpoint,
+    bool allowed,
+    const std::string& policy,
+    long long usage,
+    long long meta_requests,
+    long long meta_period,
+    long long meta_burst
+) {
+    // Unsynchronized read: enable_analytics happens at startup, before any
+    // traffic; once set the pointer never changes back to null.
+    AnalyticsBatcher* batcher = analytics_batcher.get();
+    if (!batcher) return;
+
+    AnalyticsEvent ev;
+    ev.ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    ev.key = hashed_key;
+    ev.endpoint = endpoint;
+    ev.allowed = allowed ? 1 : 0;
+    ev.policy = policy;
+    ev.usage = usage;
+    ev.meta_requests = meta_requests;
+    ev.meta_period = meta_period;
+    ev.meta_burst = meta_burst;
+    batcher->record(std::move(ev));
+}
+
+std::vector<std::string> RedisClient::read_cached(
+    const std::string& command,
+    const std::string& key
+) {
+    {
+        std::lock_guard<std::mutex> lock(tracking_cache_mutex);
+        if (!tracking_cache) {
+            tracking_cache = std::make_unique<TrackingCache>(
+                host, port, unix_socket_path, timeout_ms);
+        }
+    }
+    return tracking_cache->read(command, key);
+}
+
+std::vector<std::vector<long long>> RedisClient::eval_script_batch(
+    const std::string& script_sha,
+    const std::string& script_content,
+    const std::vector<EvalCall>& calls,
+    const std::string& key_prefix
+) {
+    // Hash keys inside C++, same as eval_script
+    std::vector<EvalCall> hashed_calls;
+    hashed_calls.reserve(calls.size());
+
+    for (const auto& call : calls) {
+        std::vector<std::string> hashed_keys;
+        hashed_keys.reserve(call.first.size());
+        for (const auto& k : call.first) {
+            hashed_keys.push_back(key_cache.get_or_compute(k, key_prefix));
+        }
+        hashed_calls.emplace_back(std::move(hashed_keys), call.second);
+    }
+
+    try {
+        return eval_sha_batch(script_sha, hashed_calls);
+    } catch (const CircuitOpenError&) {
+        std::vector<std::vector<long long>> verdicts;
+        verdicts.reserve(calls.size());
+        for (size_t i = 0; i < calls.size(); i++) {
+            verdicts.push_back(circuit_fail_open
+                ? std::vector<long long>{0, 0, 0}
+                : std::vector<long long>{-1, 1, 0});
+        }
+        return verdicts;
     } catch (const std::runtime_error& e) {
         std::string err = e.what();
         if (err == "NOSCRIPT") {
             spdlog::warn("NOSCRIPT received, re-loading script...");
             load_script(script_content);
-            return eval_sha(script_sha, hashed_keys, args);
+            return eval_sha_batch(script_sha, hashed_calls);
         }
         throw;
     }
@@ -3,25 +3,237 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <stdexcept>
 #include <condition_variable>
-#include <queue>
+#include <atomic>
 #include <thread>
 #include <functional>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <hiredis.h>
 #include <spdlog/spdlog.h>
+#include "mpmc_queue.hpp"
+#include "lru_cache.hpp"
+#include "freq_sketch.hpp"
+#include "metrics.hpp"
+
+class TokenLeaseManager;
+class ShmDecisionCache;
+class TrackingCache;
+class AnalyticsBatcher;
+
+// Thrown when the circuit is open: Redis is known-unreachable and the caller
+// gets an answer in microseconds instead of waiting out retries.
+struct CircuitOpenError : std::runtime_error {
+    CircuitOpenError() : std::runtime_error("Circuit open: Redis unavailable") {}
+};
 
 class RedisClient {
 private:
     std::string host;
     int port;
     int timeout_ms;
+
+    // Non-empty path switches the whole pool to a Unix domain socket (for
+    // sidecar/colocated Redis); host/port are ignored in that case.
+    std::string unix_socket_path;
     
-    std::queue<redisContext*> connection_pool;
+    // Lock-free ring holds idle connections; checkout/return are a couple of
+    // atomics. The mutex/condvar pair is only the slow-path parking lot for
+    // threads that find the ring empty.
+    MpmcQueue<redisContext*> connection_pool;
     size_t pool_size;
-    
+
+    // Connections alive anywhere (idle in the ring, checked out, or parked
+    // in a thread-affinity slot). Evicting a broken context decrements this;
+    // the maintenance thread replenishes back up to pool_size off the
+    // request path.
+    std::atomic<size_t> live_connections{0};
+
+    // Thread-affinity mode (constructor flag): each calling thread parks a
+    // sticky connection in thread-local storage between checks, so the
+    // steady-state checkout is one TLS load and one uncontended atomic
+    // exchange on the thread's own slot — no shared ring traffic at all.
+    // The shared pool stays the fallback when threads outnumber
+    // connections, and the maintenance thread returns sticky connections
+    // that sat idle for a while (or whose thread exited) to the pool.
+    bool thread_affinity;
+
+    struct AffinitySlot {
+        std::atomic<redisContext*> ctx{nullptr};  // parked between calls
+        std::atomic<long long> last_used_ms{0};   // steady clock, for reclaim
+    };
+
+    // Shared between the client, each thread's TLS holder and the
+    // maintenance thread; outlives the client so a late thread exit never
+    // touches freed memory (client is nulled in the destructor).
+    struct AffinityRegistry {
+        std::mutex mtx;
+        RedisClient* client = nullptr;
+        std::vector<std::shared_ptr<AffinitySlot>> slots;
+    };
+    std::shared_ptr<AffinityRegistry> affinity_registry;
+
+    // Per-thread binding; the destructor runs at thread exit and frees the
+    // parked connection (maintenance replenishes the pool).
+    struct TlsAffinity {
+        RedisClient* owner = nullptr;
+        std::shared_ptr<AffinityRegistry> registry;
+        std::shared_ptr<AffinitySlot> slot;
+        ~TlsAffinity();
+    };
+    static TlsAffinity& tls_affinity();
+
+    // Maintenance-thread side: push long-idle sticky connections back to the
+    // shared ring and drop slots whose threads have exited.
+    void reclaim_idle_affinity_connections();
+
     std::mutex pool_mutex;
     std::condition_variable pool_cv;
-    bool shutting_down = false;
+    std::atomic<bool> shutting_down{false};
+
+    // Denied verdicts come back with a retry_after deadline; until that
+    // deadline passes, every further check of the same key is guaranteed to
+    // be denied again, so we answer it locally instead of paying a round
+    // trip. Sharded to keep lock hold times negligible under many threads.
+    struct DenialCache {
+        static constexpr size_t kShards = 16;
+        static constexpr size_t kMaxEntriesPerShard = 4096;
+
+        struct Shard {
+            std::mutex mtx;
+            std::unordered_map<std::string, std::chrono::steady_clock::time_point> blocked_until;
+        };
+        std::array<Shard, kShards> shards;
+
+        // Seconds (rounded up) until the key unblocks, or 0 if not cached.
+        long long lookup(const std::string& key);
+        void insert(const std::string& key, long long retry_after_s);
+    };
+
+    DenialCache denial_cache;
+    bool denial_cache_enabled;
+
+    // Circuit breaker: after kFailureThreshold consecutive connection-level
+    // failures the circuit opens and eval paths answer immediately with the
+    // configured fail-open/fail-closed verdict. A background probe thread
+    // PINGs while open and closes the circuit on recovery, so no request
+    // thread ever sleeps waiting for Redis to come back.
+    struct CircuitBreaker {
+        static constexpr int kFailureThreshold = 5;
+
+        std::atomic<int> consecutive_failures{0};
+        std::atomic<bool> open{false};
+
+        bool is_open() const { return open.load(std::memory_order_relaxed); }
+
+        void record_success() {
+            consecutive_failures.store(0, std::memory_order_relaxed);
+        }
+
+        void record_failure() {
+            if (consecutive_failures.fetch_add(1, std::memory_order_relaxed) + 1
+                    >= kFailureThreshold) {
+                open.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        void close() {
+            consecutive_failures.store(0, std::memory_order_relaxed);
+            open.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    CircuitBreaker circuit;
+    bool circuit_fail_open;
+    std::thread maintenance_thread;
+
+    // Background pool keeper: probes Redis with PING while the circuit is
+    // open, replenishes evicted connections up to pool_size, and
+    // health-checks idle connections — all off the request path, so callers
+    // never pay connection-establishment cost inline.
+    void maintenance_loop();
+
+    // raw key -> prefixed hashed key; hot identities skip SHA-256 entirely.
+    HashedKeyCache key_cache;
+
+    // Lazily created on first lease_check; owns the background refresher.
+    std::unique_ptr<TokenLeaseManager> lease_manager;
+    std::mutex lease_manager_mutex;
+
+    // Lazily created on first read_cached; RESP3 CLIENT TRACKING cache on a
+    // dedicated connection (see tracking_cache.hpp).
+    std::unique_ptr<TrackingCache> tracking_cache;
+    std::mutex tracking_cache_mutex;
+
+    // Created by enable_analytics; background XADD batcher off the request
+    // path (see analytics_batcher.hpp).
+    std::unique_ptr<AnalyticsBatcher> analytics_batcher;
+    std::mutex analytics_batcher_mutex;
+
+    // Optional cross-process verdict cache (see shm_cache.hpp); null when
+    // no shm_cache_name was given.
+    std::unique_ptr<ShmDecisionCache> shm_cache;
+
+    // Hot-key sharding (see enable_hot_key_sharding): a count-min sketch
+    // spots keys whose rate crosses hot_threshold within a decay window, and
+    // eval_script fans those limits out across num_shards sub-keys, each
+    // granted rate/N. The maintenance thread decays the sketch and runs the
+    // rebalance script so the shards do not drift apart.
+    struct HotKeySharder {
+        static constexpr size_t kMaxTrackedHotKeys = 128;
+
+        int num_shards;
+        uint32_t hot_threshold;
+        std::string policy;           // selects the rate/N arg-scaling rule
+        std::string rebalance_script; // empty = no rebalancing
+        std::string rebalance_sha;    // loaded lazily by the maintenance thread
+        FreqSketch sketch;
+        std::atomic<uint64_t> next_shard{0};
+
+        std::mutex hot_mutex;
+        std::unordered_set<std::string> hot_keys; // base keys currently fanned out
+    };
+    std::unique_ptr<HotKeySharder> sharder; // null = sharding disabled
+
+    // Counts the key in the sketch and, when hot, rewrites keys/args in
+    // place: every key gets a ":s<i>" shard suffix and the rate args are
+    // scaled so each shard grants rate/N.
+    void apply_hot_key_sharding(std::vector<std::string>& hashed_keys,
+                                std::vector<long long>& args);
+
+    // Maintenance-thread side: decay the sketch, drop keys that cooled off,
+    // and run shard_rebalance.lua over the rest.
+    void rebalance_hot_keys();
+
+    // Script registry: name -> {content, sha}, populated once at startup via
+    // register_script so per-call paths never carry the script body. Entries
+    // are immutable shared_ptrs, so eval_by_name only copies a pointer under
+    // the lock.
+    struct RegisteredScript {
+        std::string content;
+        std::string sha;
+    };
+    std::mutex script_registry_mutex;
+    std::unordered_map<std::string, std::shared_ptr<const RegisteredScript>> script_registry;
+
+    // Lock-free observability (see metrics.hpp): padded atomic counters and
+    // latency histograms, recorded with relaxed RMWs on the hot path and
+    // snapshotted by get_metrics without any lock.
+    struct CoreMetrics {
+        flux::PaddedCounter checks;           // eval_script entries
+        flux::PaddedCounter allows;
+        flux::PaddedCounter denies;
+        flux::PaddedCounter retries;          // retry attempts after failures
+        flux::PaddedCounter noscript_reloads;
+        flux::PaddedCounter pool_waits;       // checkout took the slow path
+        flux::AtomicHistogram eval_us;        // eval_sha round-trip latency
+        flux::AtomicHistogram checkout_us;    // ConnectionGuard wait time
+    };
+    CoreMetrics metrics;
 
     // Helper: Create a single raw connection
     redisContext* create_connection();
@@ -30,33 +242,68 @@ private:
     void setup_logging(const std::string& log_path, bool enable_console_logging);
 
 public:
-    // Constructor: Builds the pool immediately
-    RedisClient(std::string host, int port, size_t pool_size, int timeout_ms, std::string log_path, bool enable_console_logging = false);
+    // Constructor: warms the pool with parallel connects and returns once
+    // min_pool_size connections are ready (0 means warm the full pool); the
+    // maintenance thread grows the pool toward pool_size in the background.
+    RedisClient(std::string host, int port, size_t pool_size, int timeout_ms, std::string log_path, bool enable_console_logging = false,
+                bool enable_denial_cache = true, size_t key_cache_size = 10000,
+                const std::string& shm_cache_name = "",
+                const std::string& unix_socket_path = "",
+                bool circuit_fail_open = true,
+                size_t min_pool_size = 0,
+                bool thread_affinity = false);
 
     // Destructor: Drains the pool
     ~RedisClient();
 
-    // Connection Guard for RAII-style pool borrowing
+    // Connection Guard for RAII-style pool borrowing. A context whose err
+    // flag is set (I/O error, timeout — hiredis marks it dead and it can
+    // never carry another command) is freed instead of returned, so the next
+    // caller never pays a full timeout on a corpse connection; the
+    // maintenance thread replaces it in the background.
     struct ConnectionGuard {
         RedisClient& parent;
         redisContext* ctx;
-        ConnectionGuard(RedisClient& client);
+        bool from_affinity = false; // checkin parks in TLS instead of the ring
+        // wait_budget_ms > 0 bounds the drained-pool condvar wait; past it
+        // the checkout throws "Deadline exceeded" instead of parking forever.
+        explicit ConnectionGuard(RedisClient& client, long long wait_budget_ms = 0);
         ~ConnectionGuard();
     };
 
-    // Generic Retry Wrapper
+    // Generic Retry Wrapper. deadline_ms > 0 bounds the whole call (all
+    // attempts included): each attempt's socket timeout is clamped to the
+    // remaining budget and the call is abandoned once the budget is spent.
     template <typename Func>
-    typename std::invoke_result<Func, redisContext*>::type 
-    execute_with_retry(Func func, int max_retries = 3, int base_delay_ms = 50);
+    typename std::invoke_result<Func, redisContext*>::type
+    execute_with_retry(Func func, int max_retries = 3, int base_delay_ms = 50,
+                       int deadline_ms = 0);
 
     // Public API
     std::string ping();
     std::string load_script(const std::string& script_content);
+
+    // Load `content` into Redis and remember it under `name`; returns the
+    // SHA1. Idempotent: re-registering a name replaces its entry.
+    std::string register_script(const std::string& name, const std::string& content);
+
+    // eval_script without the per-call script payload: sha and NOSCRIPT
+    // fallback content both come from the registry.
+    std::vector<long long> eval_by_name(
+        const std::string& name,
+        const std::vector<std::string>& keys,
+        const std::vector<long long>& args,
+        const std::string& key_prefix = "",
+        int deadline_ms = 0
+    );
     
+    // deadline_ms > 0 caps the whole call (connection checkout, all retry
+    // attempts, socket I/O); 0 means per-attempt timeout_ms only.
     std::vector<long long> eval_sha(
         const std::string& script_sha,
         const std::vector<std::string>& keys,
-        const std::vector<long long>& args
+        const std::vector<long long>& args,
+        int deadline_ms = 0
     );
 
     std::vector<long long> eval_script(
@@ -64,28 +311,145 @@ public:
         const std::string& script_content,
         const std::vector<std::string>& keys,
         const std::vector<long long>& args,
+        const std::string& key_prefix = "",
+        int deadline_ms = 0
+    );
+
+    // One (keys, args) pair per script invocation in a batch.
+    using EvalCall = std::pair<std::vector<std::string>, std::vector<long long>>;
+
+    std::vector<std::vector<long long>> eval_sha_batch(
+        const std::string& script_sha,
+        const std::vector<EvalCall>& calls
+    );
+
+    std::vector<std::vector<long long>> eval_script_batch(
+        const std::string& script_sha,
+        const std::string& script_content,
+        const std::vector<EvalCall>& calls,
+        const std::string& key_prefix = ""
+    );
+
+    // Turn on automatic hot-key sharding: keys whose request rate crosses
+    // hot_threshold (counted per ~5s decay window) are fanned out across
+    // num_shards sub-keys, each granted rate/N. policy names the registered
+    // rate-limit algorithm so the right args are scaled; rebalance_script is
+    // the content of shard_rebalance.lua (empty disables rebalancing).
+    void enable_hot_key_sharding(int num_shards, int hot_threshold,
+                                 const std::string& policy,
+                                 const std::string& rebalance_script = "");
+
+    // Start the background analytics batcher targeting `stream_key`.
+    // Idempotent; replaces the batcher if the stream changes.
+    void enable_analytics(const std::string& stream_key, long long maxlen,
+                          size_t ring_capacity = 8192);
+
+    // Enqueue one analytics event (no-op unless enable_analytics was called).
+    // Never blocks and never touches the network on the calling thread.
+    void record_analytics_event(
+        const std::string& hashed_key,
+        const std::string& endpoint,
+        bool allowed,
+        const std::string& policy,
+        long long usage,
+        long long meta_requests,
+        long long meta_period,
+        long long meta_burst
+    );
+
+    // Cached read for stats/monitor polling: GET/HGETALL/SMEMBERS served from
+    // an in-process RESP3 tracking cache until Redis invalidates the key.
+    // Flat result: GET -> {value}, HGETALL -> field,value pairs, SMEMBERS ->
+    // members; empty vector for a missing key.
+    std::vector<std::string> read_cached(
+        const std::string& command,
+        const std::string& key
+    );
+
+    // Snapshot of the core metrics: counters plus p50/p90/p99/p99.9/max for
+    // the eval and checkout histograms (microseconds). Lock-free — safe to
+    // scrape at any rate.
+    std::unordered_map<std::string, long long> get_metrics();
+
+    // Token-lease mode: batch-reserve quota via token_lease.lua and serve
+    // checks from a local counter (see TokenLeaseManager).
+    std::vector<long long> lease_check(
+        const std::string& script_sha,
+        const std::string& script_content,
+        const std::string& raw_key,
+        long long capacity,
+        long long refill_time_ms,
+        long long batch_size,
         const std::string& key_prefix = ""
     );
 };
 
 // Template implementation must be in header (or explicitly instantiated)
 template <typename Func>
-typename std::invoke_result<Func, redisContext*>::type 
-RedisClient::execute_with_retry(Func func, int max_retries, int base_delay_ms) {
+typename std::invoke_result<Func, redisContext*>::type
+RedisClient::execute_with_retry(Func func, int max_retries, int base_delay_ms,
+                                int deadline_ms) {
+    (void)base_delay_ms; // no in-request sleeps: the circuit breaker handles outages
+
+    if (circuit.is_open()) throw CircuitOpenError();
+
+    const bool has_deadline = deadline_ms > 0;
+    const auto deadline = std::chrono::steady_clock::now()
+                        + std::chrono::milliseconds(deadline_ms);
+
     int attempt = 0;
     while (true) {
+        // Per-attempt socket timeout: the connect timeout by default, clamped
+        // to whatever is left of the caller's budget.
+        long long budget_ms = timeout_ms;
+        if (has_deadline) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                throw std::runtime_error("Deadline exceeded");
+            }
+            if (remaining < budget_ms) budget_ms = remaining;
+        }
+
         try {
-            ConnectionGuard guard(*this);
-            return func(guard.ctx);
+            ConnectionGuard guard(*this, has_deadline ? budget_ms : 0);
+
+            struct timeval tv;
+            tv.tv_sec = budget_ms / 1000;
+            tv.tv_usec = (budget_ms % 1000) * 1000;
+            redisSetTimeout(guard.ctx, tv);
+
+            auto result = func(guard.ctx);
+            circuit.record_success();
+            return result;
         } catch (const std::exception& e) {
+            std::string err = e.what();
+
+            // Script-level errors are not connectivity failures: retrying or
+            // counting them against the circuit would be wrong. Surface them
+            // immediately (NOSCRIPT is handled by the eval_script fallback).
+            if (err == "NOSCRIPT" || err.rfind("Lua error:", 0) == 0) throw;
+
+            // A blown budget is the caller's deadline, not a connectivity
+            // failure: retrying (or charging the circuit) would be wrong.
+            if (err == "Deadline exceeded") throw;
+
+            circuit.record_failure();
             attempt++;
-            spdlog::warn("Attempt {}/{} failed: {}. Retrying in {}ms...", attempt, max_retries, e.what(), base_delay_ms * attempt);
-            
+            metrics.retries.inc();
+
+            if (circuit.is_open()) {
+                spdlog::error("Circuit opened after repeated failures: {}", err);
+                throw CircuitOpenError();
+            }
             if (attempt > max_retries) {
-                spdlog::error("All {} attempts failed. Final error: {}", max_retries, e.what());
-                throw; 
+                spdlog::error("All {} attempts failed. Final error: {}", max_retries, err);
+                throw;
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(base_delay_ms * attempt));
+            // Immediate retry on a fresh connection; during a real outage the
+            // breaker opens within kFailureThreshold attempts instead of
+            // stacking 50/100/150ms sleeps on every request thread.
+            spdlog::warn("Attempt {}/{} failed: {}. Retrying...", attempt, max_retries, err);
         }
     }
 }
\ No newline at end of file
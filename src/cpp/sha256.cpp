@@ -3,17 +3,23 @@
  * Based on reputable open source implementations for C++11
  */
 #include "sha256.hpp"
-#include <vector>
-#include <iomanip>
-#include <sstream>
+#include "sha256_arch.hpp"
 #include <cstring>
 
+#if defined(FLUX_SHA256_X86) && defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+#if defined(FLUX_SHA256_ARM) && defined(__linux__)
+  #include <sys/auxv.h>
+  #include <asm/hwcap.h>
+#endif
+
 // internal rotation helpers
 inline uint32_t right_rot(uint32_t value, unsigned int count) {
     return value >> count | value << (32 - count);
 }
 
-void sha256_transform(uint32_t* state, const uint8_t* data) {
+void sha256_transform_scalar(uint32_t* state, const uint8_t* data) {
     uint32_t data32[64];
     for (int i = 0, j = 0; i < 16; i++, j += 4) {
         data32[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
@@ -54,33 +60,138 @@ void sha256_transform(uint32_t* state, const uint8_t* data) {
     state[4] += e; state[5] += f; state[6] += g; state[7] += h;
 }
 
-std::string sha256(const std::string& input) {
-    uint32_t state[8] = {
-        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-    };
+// ----------------------------------------------------------------------------
+// Runtime CPU dispatch
+// ----------------------------------------------------------------------------
+
+using sha256_transform_fn = void (*)(uint32_t* state, const uint8_t* data);
+
+// Does this CPU implement the SHA-256 instruction extensions?
+static bool cpu_has_sha256_extensions() {
+#if defined(FLUX_SHA256_X86)
+  #if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 29)) != 0; // EBX bit 29: SHA
+  #else
+    return __builtin_cpu_supports("sha") != 0;
+  #endif
+#elif defined(FLUX_SHA256_ARM)
+  #if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+  #elif defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+    return true; // the compile baseline already guarantees the extension
+  #else
+    return false;
+  #endif
+#else
+    return false;
+#endif
+}
+
+static sha256_transform_fn resolve_sha256_transform() {
+#if defined(FLUX_SHA256_X86)
+    if (cpu_has_sha256_extensions()) return sha256_transform_shani;
+#elif defined(FLUX_SHA256_ARM)
+    if (cpu_has_sha256_extensions()) return sha256_transform_armv8;
+#endif
+    return sha256_transform_scalar;
+}
+
+// Resolved once at load; every block goes through this pointer.
+static const sha256_transform_fn sha256_transform = resolve_sha256_transform();
+
+// ----------------------------------------------------------------------------
+// Streaming context
+// ----------------------------------------------------------------------------
+
+void Sha256Ctx::reset() {
+    state[0] = 0x6a09e667; state[1] = 0xbb67ae85;
+    state[2] = 0x3c6ef372; state[3] = 0xa54ff53a;
+    state[4] = 0x510e527f; state[5] = 0x9b05688c;
+    state[6] = 0x1f83d9ab; state[7] = 0x5be0cd19;
+    block_len = 0;
+    total_len = 0;
+}
+
+void Sha256Ctx::update(const void* data, size_t len) {
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+    total_len += len;
+
+    // Complete a previously staged partial block first
+    if (block_len > 0) {
+        size_t take = 64 - block_len;
+        if (take > len) take = len;
+        std::memcpy(block + block_len, input, take);
+        block_len += take;
+        input += take;
+        len -= take;
+
+        if (block_len < 64) return;
+        sha256_transform(state, block);
+        block_len = 0;
+    }
 
-    std::vector<uint8_t> buffer(input.begin(), input.end());
-    uint64_t bit_len = buffer.size() * 8;
-    
-    // Padding
-    buffer.push_back(0x80);
-    while ((buffer.size() * 8) % 512 != 448) {
-        buffer.push_back(0x00);
+    // Full blocks straight from the caller's buffer -- no copy
+    while (len >= 64) {
+        sha256_transform(state, input);
+        input += 64;
+        len -= 64;
     }
 
-    for (int i = 7; i >= 0; i--) {
-        buffer.push_back((bit_len >> (i * 8)) & 0xff);
+    // Stage the tail
+    if (len > 0) {
+        std::memcpy(block, input, len);
+        block_len = len;
     }
+}
 
-    for (size_t i = 0; i < buffer.size(); i += 64) {
-        sha256_transform(state, &buffer[i]);
+void Sha256Ctx::final(uint8_t digest[32]) {
+    uint64_t bit_len = total_len * 8;
+
+    // Padding: 0x80, zeros, then the 64-bit big-endian message length
+    block[block_len++] = 0x80;
+    if (block_len > 56) {
+        std::memset(block + block_len, 0, 64 - block_len);
+        sha256_transform(state, block);
+        block_len = 0;
+    }
+    std::memset(block + block_len, 0, 56 - block_len);
+    for (int i = 0; i < 8; i++) {
+        block[56 + i] = (uint8_t)((bit_len >> ((7 - i) * 8)) & 0xff);
     }
+    sha256_transform(state, block);
 
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
     for (int i = 0; i < 8; i++) {
-        ss << std::setw(8) << state[i];
+        digest[i * 4 + 0] = (uint8_t)(state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)(state[i]);
+    }
+}
+
+void sha256_hex(const uint8_t digest[32], char* out) {
+    static const char hex_table[] = "0123456789abcdef";
+    for (int i = 0; i < 32; i++) {
+        out[i * 2] = hex_table[digest[i] >> 4];
+        out[i * 2 + 1] = hex_table[digest[i] & 0x0f];
     }
-    return ss.str();
+}
+
+std::string sha256(const std::string& input) {
+    return sha256_key(std::string(), input);
+}
+
+std::string sha256_key(const std::string& prefix, const std::string& raw) {
+    Sha256Ctx ctx;
+    ctx.update(raw.data(), raw.size());
+
+    uint8_t digest[32];
+    ctx.final(digest);
+
+    // Single allocation: the result string, sized exactly
+    std::string out(prefix.size() + 64, '\0');
+    std::memcpy(&out[0], prefix.data(), prefix.size());
+    sha256_hex(digest, &out[prefix.size()]);
+    return out;
 }
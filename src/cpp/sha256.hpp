@@ -2,7 +2,35 @@
 #define SHA256_HPP
 
 #include <string>
+#include <cstdint>
+#include <cstddef>
 
+// Streaming SHA-256 context (init/update/final).
+//
+// update() consumes full 64-byte blocks directly from the caller's buffer and
+// only stages a partial tail in the fixed on-stack block, so hashing performs
+// no heap allocation. Reusable after reset().
+struct Sha256Ctx {
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t block_len;
+    uint64_t total_len;
+
+    Sha256Ctx() { reset(); }
+
+    void reset();
+    void update(const void* data, size_t len);
+    void final(uint8_t digest[32]);
+};
+
+// Write the digest as 64 lowercase hex characters (no terminator) into out.
+void sha256_hex(const uint8_t digest[32], char* out);
+
+// One-shot convenience: hex digest of str.
 std::string sha256(const std::string& str);
 
+// prefix + hex(sha256(raw)) with a single allocation for the result -- the
+// hot-path form used when building prefixed Redis keys.
+std::string sha256_key(const std::string& prefix, const std::string& raw);
+
 #endif // SHA256_HPP
@@ -0,0 +1,25 @@
+#ifndef SHA256_ARCH_HPP
+#define SHA256_ARCH_HPP
+
+#include <cstdint>
+
+// Internal: per-architecture SHA-256 block transforms.
+//
+// sha256.cpp picks an implementation once at startup (runtime CPU feature
+// detection) and routes every 64-byte block through a function pointer.
+// The hardware variants live in sha256_hw.cpp, which is compiled with the
+// SHA-extension flags for the target architecture (see CMakeLists.txt).
+
+void sha256_transform_scalar(uint32_t* state, const uint8_t* data);
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FLUX_SHA256_X86 1
+void sha256_transform_shani(uint32_t* state, const uint8_t* data);
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define FLUX_SHA256_ARM 1
+void sha256_transform_armv8(uint32_t* state, const uint8_t* data);
+#endif
+
+#endif // SHA256_ARCH_HPP
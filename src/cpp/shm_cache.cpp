@@ -0,0 +1,118 @@
+#include "shm_cache.hpp"
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <stdexcept>
+
+// ============================================================================
+// ShmDecisionCache Implementation
+// ============================================================================
+
+namespace {
+constexpr uint64_t kMagic = 0x464c55584348451ULL; // "FLUXCHE"
+}
+
+ShmDecisionCache::ShmDecisionCache(const std::string& name, size_t slot_count)
+    : shm_name("/" + name), slot_count(slot_count == 0 ? 1 : slot_count) {
+
+    mapping_size = sizeof(Header) + this->slot_count * sizeof(Slot);
+
+    // ftruncate zero-fills on creation, so a fresh segment starts with every
+    // slot empty and magic unset; attaching processes see either state.
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error(fmt::format("shm_open({}) failed: {}", shm_name, strerror(errno)));
+    }
+    if (ftruncate(fd, (off_t)mapping_size) != 0) {
+        close(fd);
+        throw std::runtime_error(fmt::format("ftruncate({}) failed: {}", shm_name, strerror(errno)));
+    }
+
+    mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the segment alive
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error(fmt::format("mmap({}) failed: {}", shm_name, strerror(errno)));
+    }
+
+    header = static_cast<Header*>(mapping);
+    slots = reinterpret_cast<Slot*>(static_cast<uint8_t*>(mapping) + sizeof(Header));
+
+    // Idempotent initialization: every attacher writes the same values, so
+    // there is no creator/attacher handshake to get wrong.
+    uint64_t expected = 0;
+    if (header->magic.compare_exchange_strong(expected, kMagic)) {
+        header->slot_count = this->slot_count;
+    } else if (header->magic.load() != kMagic || header->slot_count != this->slot_count) {
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+        throw std::runtime_error(fmt::format(
+            "shm segment {} exists with incompatible layout", shm_name));
+    }
+
+    spdlog::debug("ShmDecisionCache: attached to {} ({} slots)", shm_name, this->slot_count);
+}
+
+ShmDecisionCache::~ShmDecisionCache() {
+    // Never shm_unlink: sibling workers share the segment.
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_size);
+    }
+}
+
+uint64_t ShmDecisionCache::hash_key(const std::string& key) {
+    // FNV-1a: stable across processes and builds, unlike std::hash.
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h == 0 ? 1 : h; // 0 marks an empty slot
+}
+
+long long ShmDecisionCache::lookup_denial(const std::string& hashed_key, long long now_epoch_ms) {
+    uint64_t h = hash_key(hashed_key);
+    Slot& slot = slots[h % slot_count];
+
+    // Seqlock read: retry on a torn snapshot, give up quickly under write
+    // pressure -- a miss just means one extra round trip.
+    for (int attempt = 0; attempt < 3; attempt++) {
+        uint64_t seq1 = slot.seq.load(std::memory_order_acquire);
+        if (seq1 & 1) continue; // write in flight
+
+        uint64_t key_hash = slot.key_hash;
+        int64_t blocked_until = slot.blocked_until_ms;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t seq2 = slot.seq.load(std::memory_order_relaxed);
+        if (seq1 != seq2) continue;
+
+        if (key_hash != h || blocked_until <= now_epoch_ms) return 0;
+        return (blocked_until - now_epoch_ms + 999) / 1000;
+    }
+    return 0;
+}
+
+void ShmDecisionCache::publish(const std::string& hashed_key, bool allowed,
+                               long long blocked_until_epoch_ms, long long tat_ms) {
+    uint64_t h = hash_key(hashed_key);
+    Slot& slot = slots[h % slot_count];
+
+    // Claim the slot by bumping the sequence to odd; if another writer is in
+    // flight, drop the update -- publishing is best effort.
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    if (seq & 1) return;
+    if (!slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+        return;
+    }
+
+    slot.key_hash = h;
+    slot.blocked_until_ms = allowed ? 0 : blocked_until_epoch_ms;
+    slot.tat_ms = tat_ms;
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
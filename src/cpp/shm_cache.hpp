@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Per-host shared-memory decision cache.
+//
+// Multi-process deployments (e.g. 16 gunicorn workers) each keep their own
+// in-process caches, so a hot client identity is re-checked against Redis
+// once per worker. This cache is a fixed-size open-addressed table in a named
+// POSIX shared-memory segment: after a real Redis round trip any worker
+// publishes the verdict, and every worker on the host can read it lock-free.
+//
+// Each slot is seqlock-protected (sequence odd = write in progress; readers
+// retry on a torn read, writers claim the slot with a CAS and never block).
+// Only denials short-circuit checks -- an "allow" must still consume quota on
+// Redis -- but allowed verdicts carry the GCRA TAT for observability.
+// Deadlines use the system clock (epoch ms) so they are comparable across
+// processes. Collisions simply overwrite: this is a cache, last writer wins.
+class ShmDecisionCache {
+public:
+    // Creates or attaches to shared segment "/<name>". Throws on failure.
+    explicit ShmDecisionCache(const std::string& name, size_t slot_count = 65536);
+    ~ShmDecisionCache();
+
+    ShmDecisionCache(const ShmDecisionCache&) = delete;
+    ShmDecisionCache& operator=(const ShmDecisionCache&) = delete;
+
+    // If the key is published as denied past now, returns the remaining
+    // retry_after in seconds (rounded up); 0 otherwise.
+    long long lookup_denial(const std::string& hashed_key, long long now_epoch_ms);
+
+    // Publish a verdict. For denials pass the absolute unblock deadline;
+    // for allows pass 0 and (for GCRA) the new TAT.
+    void publish(const std::string& hashed_key, bool allowed,
+                 long long blocked_until_epoch_ms, long long tat_ms);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq;      // seqlock; odd while a write is in flight
+        uint64_t key_hash;              // 0 = empty slot
+        int64_t blocked_until_ms;       // epoch ms; 0 = not blocked
+        int64_t tat_ms;                 // last published GCRA TAT (0 if n/a)
+        uint8_t pad[32];                // one slot per cache line
+    };
+    static_assert(sizeof(Slot) == 64, "Slot must be one cache line");
+
+    struct Header {
+        std::atomic<uint64_t> magic;
+        uint64_t slot_count;
+        uint8_t pad[48];
+    };
+
+    std::string shm_name;
+    size_t slot_count;
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    Header* header = nullptr;
+    Slot* slots = nullptr;
+
+    static uint64_t hash_key(const std::string& key);
+};
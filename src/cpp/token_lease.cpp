@@ -0,0 +1,230 @@
+#include "token_lease.hpp"
+#include "redis_client.hpp"
+#include "sha256.hpp"
+#include <chrono>
+
+// ============================================================================
+// TokenLeaseManager Implementation
+// ============================================================================
+
+TokenLeaseManager::TokenLeaseManager(RedisClient& client) : client(client) {
+    refresher = std::thread(&TokenLeaseManager::refresher_loop, this);
+}
+
+TokenLeaseManager::~TokenLeaseManager() {
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex);
+        stop_requested = true;
+    }
+    refresh_cv.notify_all();
+    if (refresher.joinable()) refresher.join();
+}
+
+long long TokenLeaseManager::steady_now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ----------------------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------------------
+
+std::vector<long long> TokenLeaseManager::check(
+    const std::string& script_sha,
+    const std::string& script_content,
+    const std::string& raw_key,
+    long long capacity,
+    long long refill_time_ms,
+    long long batch_size,
+    const std::string& key_prefix
+) {
+    if (batch_size < 1) batch_size = 1;
+
+    std::string hashed_key = sha256_key(key_prefix, raw_key);
+    auto lease = get_lease(hashed_key, script_sha, script_content,
+                           capacity, refill_time_ms, batch_size);
+    lease->last_used_ms.store(steady_now_ms(), std::memory_order_relaxed);
+
+    // Fast path: consume one locally leased token.
+    long long prev = lease->available.fetch_sub(1, std::memory_order_acq_rel);
+    if (prev > 0) {
+        long long remaining = prev - 1;
+        // Refresh in the background before the lease drains.
+        if (remaining <= batch_size / 4 && !lease->refresh_inflight.exchange(true)) {
+            schedule_refresh(lease);
+        }
+        return {0, remaining, capacity - remaining};
+    }
+    lease->available.fetch_add(1, std::memory_order_acq_rel); // took nothing
+
+    // Redis had no tokens for us recently; honor the cached retry_after.
+    long long denied_until = lease->denied_until_ms.load(std::memory_order_acquire);
+    long long now_ms = steady_now_ms();
+    if (denied_until > now_ms) {
+        long long retry_after = (denied_until - now_ms + 999) / 1000;
+        return {-1, retry_after, capacity};
+    }
+
+    // Slow path: the local lease is empty. One thread performs the
+    // acquisition round trip; followers re-check the balance it credited.
+    std::lock_guard<std::mutex> lock(lease->acquire_mutex);
+
+    prev = lease->available.fetch_sub(1, std::memory_order_acq_rel);
+    if (prev > 0) {
+        return {0, prev - 1, capacity - (prev - 1)};
+    }
+    lease->available.fetch_add(1, std::memory_order_acq_rel);
+
+    long long granted = acquire_batch(*lease);
+    if (granted > 0) {
+        prev = lease->available.fetch_sub(1, std::memory_order_acq_rel);
+        if (prev > 0) {
+            return {0, prev - 1, capacity - (prev - 1)};
+        }
+        lease->available.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    long long retry_after =
+        (lease->denied_until_ms.load(std::memory_order_acquire) - steady_now_ms() + 999) / 1000;
+    if (retry_after < 1) retry_after = 1;
+    return {-1, retry_after, capacity};
+}
+
+// ----------------------------------------------------------------------------
+// Internals
+// ----------------------------------------------------------------------------
+
+std::shared_ptr<TokenLeaseManager::Lease> TokenLeaseManager::get_lease(
+    const std::string& hashed_key,
+    const std::string& script_sha,
+    const std::string& script_content,
+    long long capacity,
+    long long refill_time_ms,
+    long long batch_size
+) {
+    std::lock_guard<std::mutex> lock(leases_mutex);
+    auto it = leases.find(hashed_key);
+    if (it != leases.end()) return it->second;
+
+    auto lease = std::make_shared<Lease>();
+    lease->hashed_key = hashed_key;
+    lease->script_sha = script_sha;
+    lease->script_content = script_content;
+    lease->capacity = capacity;
+    lease->refill_time_ms = refill_time_ms;
+    lease->batch_size = batch_size;
+    leases[hashed_key] = lease;
+    return lease;
+}
+
+long long TokenLeaseManager::acquire_batch(Lease& lease) {
+    long long now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::vector<long long> result;
+    try {
+        result = client.eval_sha(
+            lease.script_sha,
+            {lease.hashed_key},
+            {lease.capacity, lease.refill_time_ms, now_ms, lease.batch_size}
+        );
+    } catch (const std::runtime_error& e) {
+        std::string err = e.what();
+        if (err != "NOSCRIPT") throw;
+        spdlog::warn("NOSCRIPT received, re-loading script...");
+        client.load_script(lease.script_content);
+        result = client.eval_sha(
+            lease.script_sha,
+            {lease.hashed_key},
+            {lease.capacity, lease.refill_time_ms, now_ms, lease.batch_size}
+        );
+    }
+
+    // Script returns {granted, retry_after_s, usage}
+    long long granted = result.empty() ? 0 : result[0];
+    if (granted > 0) {
+        lease.available.fetch_add(granted, std::memory_order_acq_rel);
+        lease.denied_until_ms.store(0, std::memory_order_release);
+    } else {
+        long long retry_after_s = result.size() >= 2 ? result[1] : 1;
+        if (retry_after_s < 1) retry_after_s = 1;
+        lease.denied_until_ms.store(steady_now_ms() + retry_after_s * 1000,
+                                    std::memory_order_release);
+    }
+
+    SPDLOG_DEBUG("token_lease: acquired {} token(s) for key={}", granted, lease.hashed_key);
+    return granted;
+}
+
+void TokenLeaseManager::schedule_refresh(const std::shared_ptr<Lease>& lease) {
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex);
+        refresh_queue.push_back(lease);
+    }
+    refresh_cv.notify_one();
+}
+
+void TokenLeaseManager::refresher_loop() {
+    constexpr long long kSweepIntervalMs = 5000;
+    long long last_sweep_ms = steady_now_ms();
+
+    std::unique_lock<std::mutex> lock(refresh_mutex);
+    while (true) {
+        // Bounded wait so the idle sweep below runs even with no refresh
+        // traffic at all.
+        refresh_cv.wait_for(lock, std::chrono::milliseconds(1000),
+                            [&] { return stop_requested || !refresh_queue.empty(); });
+        if (stop_requested) return;
+
+        while (!refresh_queue.empty()) {
+            auto lease = refresh_queue.front();
+            refresh_queue.pop_front();
+            lock.unlock();
+
+            try {
+                acquire_batch(*lease);
+            } catch (const std::exception& e) {
+                // Background refresh is best-effort; callers fall back to the
+                // synchronous path once the local balance runs dry.
+                spdlog::warn("token_lease: background refresh failed: {}", e.what());
+            }
+            lease->refresh_inflight.store(false, std::memory_order_release);
+
+            lock.lock();
+            if (stop_requested) return;
+        }
+
+        long long now_ms = steady_now_ms();
+        if (now_ms - last_sweep_ms >= kSweepIntervalMs) {
+            last_sweep_ms = now_ms;
+            lock.unlock();
+            evict_idle_leases(now_ms);
+            lock.lock();
+        }
+    }
+}
+
+void TokenLeaseManager::evict_idle_leases(long long now_ms) {
+    constexpr long long kMinIdleMs = 10'000;
+
+    std::lock_guard<std::mutex> lock(leases_mutex);
+    for (auto it = leases.begin(); it != leases.end();) {
+        const auto& lease = it->second;
+
+        // Refresh horizon: how long the bucket takes to refill one full
+        // batch. A lease idle that long has had its reservation returned by
+        // refill anyway, so dropping it costs nothing but the map entry.
+        long long horizon_ms = lease->batch_size * lease->refill_time_ms;
+        if (horizon_ms < kMinIdleMs) horizon_ms = kMinIdleMs;
+
+        bool idle = now_ms - lease->last_used_ms.load(std::memory_order_relaxed)
+                    >= horizon_ms;
+        if (idle && !lease->refresh_inflight.load(std::memory_order_acquire)) {
+            // In-flight check() callers hold their own shared_ptr; erasing
+            // only drops the map reference.
+            it = leases.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <unordered_map>
+
+class RedisClient;
+
+// Token-lease mode: instead of one Redis round trip per token, the process
+// atomically reserves a batch of N tokens via the token_lease.lua script and
+// serves the next N checks from a local atomic counter. A background thread
+// refreshes the lease once the local balance drops below a low-water mark, so
+// steady-state checks never wait on the network. Enforcement is approximate:
+// tokens leased by a process that dies are refilled by the bucket over time.
+class TokenLeaseManager {
+public:
+    explicit TokenLeaseManager(RedisClient& client);
+    ~TokenLeaseManager();
+
+    TokenLeaseManager(const TokenLeaseManager&) = delete;
+    TokenLeaseManager& operator=(const TokenLeaseManager&) = delete;
+
+    // Same result shape as the rate-limit scripts: {status, value, usage}
+    // with status 0 = allowed, -1 = denied (value = retry_after seconds).
+    // On allow, value is the local token balance after the check.
+    std::vector<long long> check(
+        const std::string& script_sha,
+        const std::string& script_content,
+        const std::string& raw_key,
+        long long capacity,
+        long long refill_time_ms,
+        long long batch_size,
+        const std::string& key_prefix = ""
+    );
+
+private:
+    struct Lease {
+        std::string hashed_key;
+        std::string script_sha;
+        std::string script_content;
+        long long capacity = 0;
+        long long refill_time_ms = 0;
+        long long batch_size = 0;
+
+        // Local balance; may dip below zero transiently under races, the
+        // consumer restores it when a decrement finds nothing to take.
+        std::atomic<long long> available{0};
+        // Steady-clock ms deadline while Redis itself has no tokens for us.
+        std::atomic<long long> denied_until_ms{0};
+        std::atomic<bool> refresh_inflight{false};
+        // Steady-clock ms of the last check; drives idle eviction.
+        std::atomic<long long> last_used_ms{0};
+        // Serializes the synchronous (empty-balance) acquisition path.
+        std::mutex acquire_mutex;
+    };
+
+    RedisClient& client;
+
+    std::mutex leases_mutex;
+    std::unordered_map<std::string, std::shared_ptr<Lease>> leases;
+
+    std::mutex refresh_mutex;
+    std::condition_variable refresh_cv;
+    std::deque<std::shared_ptr<Lease>> refresh_queue;
+    bool stop_requested = false;
+    std::thread refresher;
+
+    std::shared_ptr<Lease> get_lease(
+        const std::string& hashed_key,
+        const std::string& script_sha,
+        const std::string& script_content,
+        long long capacity,
+        long long refill_time_ms,
+        long long batch_size
+    );
+
+    // One round trip: reserve up to lease->batch_size tokens from Redis and
+    // credit them to the local balance. Returns the number granted.
+    long long acquire_batch(Lease& lease);
+
+    void schedule_refresh(const std::shared_ptr<Lease>& lease);
+    void refresher_loop();
+
+    // Drop leases idle past their refresh horizon (the time the bucket needs
+    // to refill a full batch, floored at 10s) so one-off keys do not pin a
+    // Lease entry for the process lifetime. Any locally held tokens are
+    // forfeited — the bucket refills them over time, same as a process death.
+    void evict_idle_leases(long long now_ms);
+
+    static long long steady_now_ms();
+};
@@ -0,0 +1,237 @@
+#include "tracking_cache.hpp"
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#ifdef _WIN32
+  #include <winsock2.h>
+#else
+  #include <poll.h>
+#endif
+
+// ============================================================================
+// TrackingCache Implementation
+// ============================================================================
+
+TrackingCache::TrackingCache(const std::string& host, int port,
+                             const std::string& unix_socket_path, int timeout_ms)
+    : host(host), port(port), unix_socket_path(unix_socket_path), timeout_ms(timeout_ms) {
+    {
+        std::lock_guard<std::mutex> lock(io_mutex);
+        connect_and_enable_tracking();
+    }
+    poller = std::thread(&TrackingCache::poll_loop, this);
+}
+
+TrackingCache::~TrackingCache() {
+    stop = true;
+    if (poller.joinable()) poller.join();
+
+    std::lock_guard<std::mutex> lock(io_mutex);
+    if (ctx) redisFree(ctx);
+}
+
+void TrackingCache::connect_and_enable_tracking() {
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    if (!unix_socket_path.empty()) {
+        ctx = redisConnectUnixWithTimeout(unix_socket_path.c_str(), timeout);
+    } else {
+        ctx = redisConnectWithTimeout(host.c_str(), port, timeout);
+    }
+
+    if (ctx == nullptr || ctx->err) {
+        std::string err = ctx ? ctx->errstr : "Allocation failure";
+        if (ctx) { redisFree(ctx); ctx = nullptr; }
+        throw std::runtime_error(fmt::format("Tracking connection failed: {}", err));
+    }
+
+    ctx->privdata = this;
+    redisSetPushCallback(ctx, &TrackingCache::push_handler);
+
+    // RESP3 is required for out-of-band invalidation pushes; on RESP2 the
+    // server would redirect them to a second connection instead.
+    redisReply* reply = (redisReply*)redisCommand(ctx, "HELLO 3");
+    if (!reply || reply->type == REDIS_REPLY_ERROR) {
+        std::string err = reply && reply->str ? reply->str : "network error";
+        if (reply) freeReplyObject(reply);
+        redisFree(ctx);
+        ctx = nullptr;
+        throw std::runtime_error("HELLO 3 failed (Redis >= 6 required): " + err);
+    }
+    freeReplyObject(reply);
+
+    reply = (redisReply*)redisCommand(ctx, "CLIENT TRACKING ON");
+    if (!reply || reply->type == REDIS_REPLY_ERROR) {
+        std::string err = reply && reply->str ? reply->str : "network error";
+        if (reply) freeReplyObject(reply);
+        redisFree(ctx);
+        ctx = nullptr;
+        throw std::runtime_error("CLIENT TRACKING ON failed: " + err);
+    }
+    freeReplyObject(reply);
+
+    spdlog::debug("TrackingCache: RESP3 tracking connection established");
+}
+
+// ----------------------------------------------------------------------------
+// Invalidation handling
+// ----------------------------------------------------------------------------
+
+void TrackingCache::push_handler(void* privdata, void* reply) {
+    auto* self = static_cast<TrackingCache*>(privdata);
+    auto* r = static_cast<redisReply*>(reply);
+    if (self && r) self->handle_invalidation(r);
+    // Custom push callbacks own the reply.
+    freeReplyObject(r);
+}
+
+void TrackingCache::handle_invalidation(redisReply* reply) {
+    // Shape: ["invalidate", [key, ...]] — a nil payload means the whole
+    // tracking table was dropped (FLUSHALL or tracking redirection loss).
+    if (reply->type != REDIS_REPLY_PUSH && reply->type != REDIS_REPLY_ARRAY) return;
+    if (reply->elements < 1) return;
+    redisReply* kind = reply->element[0];
+    if (!kind->str || std::string(kind->str) != "invalidate") return;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    if (reply->elements < 2 || reply->element[1]->type == REDIS_REPLY_NIL) {
+        cache.clear();
+        return;
+    }
+
+    redisReply* keys = reply->element[1];
+    if (keys->type != REDIS_REPLY_ARRAY) return;
+    for (size_t i = 0; i < keys->elements; i++) {
+        if (keys->element[i]->str) {
+            cache.erase(std::string(keys->element[i]->str, keys->element[i]->len));
+        }
+    }
+}
+
+void TrackingCache::poll_loop() {
+#ifndef _WIN32
+    while (!stop) {
+        int fd;
+        {
+            std::lock_guard<std::mutex> lock(io_mutex);
+            if (!ctx) {
+                // Connection died; rebuild it. Everything cached under the old
+                // tracking table is stale by definition.
+                try {
+                    connect_and_enable_tracking();
+                    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+                    cache.clear();
+                } catch (const std::exception& e) {
+                    spdlog::warn("TrackingCache: reconnect failed: {}", e.what());
+                }
+            }
+            fd = ctx ? ctx->fd : -1;
+        }
+
+        if (fd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            continue;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        int rc = ::poll(&pfd, 1, 100);
+        if (rc <= 0) continue;
+
+        std::lock_guard<std::mutex> lock(io_mutex);
+        if (!ctx || ctx->fd != fd) continue;
+
+        if (redisBufferRead(ctx) != REDIS_OK) {
+            spdlog::warn("TrackingCache: connection lost: {}", ctx->errstr);
+            redisFree(ctx);
+            ctx = nullptr;
+            continue;
+        }
+
+        // Drain the reader: invalidation pushes are routed to push_handler
+        // internally, so anything surfacing here is unexpected — just free it.
+        void* reply = nullptr;
+        while (redisGetReplyFromReader(ctx, &reply) == REDIS_OK && reply != nullptr) {
+            freeReplyObject(reply);
+            reply = nullptr;
+        }
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Cached reads
+// ----------------------------------------------------------------------------
+
+std::vector<std::string> TrackingCache::read(const std::string& command, const std::string& key) {
+    if (command != "GET" && command != "HGETALL" && command != "SMEMBERS") {
+        throw std::runtime_error("TrackingCache: unsupported command \"" + command +
+                                 "\" (GET, HGETALL, SMEMBERS)");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto key_it = cache.find(key);
+        if (key_it != cache.end()) {
+            auto cmd_it = key_it->second.find(command);
+            if (cmd_it != key_it->second.end()) {
+                hit_count++;
+                return cmd_it->second;
+            }
+        }
+    }
+
+    std::vector<std::string> values;
+    {
+        std::lock_guard<std::mutex> lock(io_mutex);
+        if (!ctx) throw std::runtime_error("TrackingCache: connection down");
+
+        const char* argv[2] = {command.c_str(), key.c_str()};
+        size_t argvlen[2] = {command.size(), key.size()};
+        redisReply* reply = (redisReply*)redisCommandArgv(ctx, 2, argv, argvlen);
+
+        if (!reply) {
+            std::string err = ctx->errstr;
+            redisFree(ctx);
+            ctx = nullptr; // poller rebuilds it
+            throw std::runtime_error("TrackingCache: read failed: " + err);
+        }
+
+        if (reply->type == REDIS_REPLY_ERROR) {
+            std::string err = reply->str ? reply->str : "unknown error";
+            freeReplyObject(reply);
+            throw std::runtime_error("TrackingCache: " + err);
+        }
+
+        if (reply->type == REDIS_REPLY_STRING) {
+            values.emplace_back(reply->str, reply->len);
+        } else if (reply->type == REDIS_REPLY_ARRAY ||
+                   reply->type == REDIS_REPLY_MAP ||
+                   reply->type == REDIS_REPLY_SET) {
+            values.reserve(reply->elements);
+            for (size_t i = 0; i < reply->elements; i++) {
+                redisReply* el = reply->element[i];
+                values.emplace_back(el->str ? std::string(el->str, el->len) : std::string());
+            }
+        }
+        // REDIS_REPLY_NIL: missing key, cached as empty so repeated polls of
+        // absent counters also stay local.
+        freeReplyObject(reply);
+
+        // Store while still holding io_mutex: the poller needs it to drain
+        // invalidation pushes, so none can slip in between the reply and the
+        // insert. (An invalidation for this key that the server sent *before*
+        // our read is also fine — processing it inline above re-arms tracking
+        // and the reply we cache is newer than it.) Inserting after the
+        // release would let a push erase first and the stale entry would then
+        // mask the key forever: tracking stops once an invalidation is sent,
+        // and the cached hit prevents the re-read that would re-arm it.
+        std::lock_guard<std::mutex> cache_lock(cache_mutex);
+        cache[key][command] = values;
+    }
+    return values;
+}
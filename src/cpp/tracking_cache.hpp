@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <hiredis.h>
+
+// RESP3 client-side cache backed by CLIENT TRACKING.
+//
+// A dedicated connection speaks RESP3 (HELLO 3) with tracking enabled; read
+// results are kept in-process and served without touching Redis until the
+// server pushes an invalidation for the key. Stats/monitor polling loops that
+// re-read mostly-unchanged counters every tick become near-free and stop
+// competing with enforcement traffic.
+//
+// Only read commands with a single key are supported (GET, HGETALL,
+// SMEMBERS): tracking invalidates per key, so multi-key or computed reads
+// (EVAL) cannot be cached safely.
+class TrackingCache {
+public:
+    TrackingCache(const std::string& host, int port,
+                  const std::string& unix_socket_path, int timeout_ms);
+    ~TrackingCache();
+
+    TrackingCache(const TrackingCache&) = delete;
+    TrackingCache& operator=(const TrackingCache&) = delete;
+
+    // Flat result: GET -> {value} (or empty for nil), HGETALL -> field,value
+    // pairs, SMEMBERS -> members. Served from cache when possible.
+    std::vector<std::string> read(const std::string& command, const std::string& key);
+
+    // Cache hits since construction; lets callers confirm the tracking path
+    // is actually absorbing their polling load.
+    long long hits() const { return hit_count.load(); }
+
+private:
+    std::string host;
+    int port;
+    std::string unix_socket_path;
+    int timeout_ms;
+
+    // Serializes request/response I/O on the single tracking connection.
+    std::mutex io_mutex;
+    redisContext* ctx = nullptr;
+
+    std::mutex cache_mutex;
+    // redis key -> command -> flattened reply.
+    std::unordered_map<std::string,
+        std::unordered_map<std::string, std::vector<std::string>>> cache;
+
+    std::atomic<long long> hit_count{0};
+    std::atomic<bool> stop{false};
+    std::thread poller;
+
+    void connect_and_enable_tracking(); // called under io_mutex
+    void poll_loop();
+
+    // hiredis push callback: receives RESP3 invalidation messages.
+    static void push_handler(void* privdata, void* reply);
+    void handle_invalidation(redisReply* reply);
+};
@@ -19,6 +19,7 @@ class RateLimitPolicy(Enum):
     TOKEN_BUCKET = "token_bucket"    # Token Bucket
     LEAKY_BUCKET = "leaky_bucket"    # Leaky Bucket
     FIXED_WINDOW = "fixed_window"    # Fixed Window (FCFS)
+    SLIDING_WINDOW = "sliding_window"  # Sliding Window Counter (two buckets)
 
 
 @dataclass
@@ -41,8 +42,11 @@ class FluxConfig:
     redis_port: int = 6379
     pool_size: int = 5
     timeout_ms: int = 200
+    unix_socket_path: str = ""  # If set, connect over a Unix domain socket instead of host/port
+    thread_affinity: bool = False  # Sticky per-thread connections (thread-per-request deployments)
     
     # Flux settings
+    backend: str = "redis"  # "redis" or "local" (embedded in-memory engine)
     key_prefix: str = "flux:"
     log_file: str = "flux_debug.log"
     fail_silently: bool = True  # If True, allow requests when Redis is down
@@ -59,6 +63,11 @@ class FluxConfig:
     jitter_enabled: bool = False
     jitter_max_ms: int = 1000
 
+    # Hot-key sharding: fan viral keys out across N sub-keys once their rate
+    # crosses the threshold (requests per ~5s window). 0 disables sharding.
+    hot_key_shards: int = 0
+    hot_key_threshold: int = 5000
+
     # Analytics
     analytics_enabled: bool = False
     analytics_port: int = 4444
@@ -134,12 +143,17 @@ def load_config(config_path: Optional[Union[str, Path]] = None) -> FluxConfig:
         redis_port=redis.get("port", 6379),
         pool_size=redis.get("pool_size", 5),
         timeout_ms=redis.get("timeout_ms", 200),
+        unix_socket_path=redis.get("unix_socket_path", ""),
+        thread_affinity=redis.get("thread_affinity", False),
+        backend=flux.get("backend", "redis"),
         key_prefix=flux.get("key_prefix", "flux:"),
         log_file=flux.get("log_file", "flux_debug.log"),
         fail_silently=flux.get("fail_silently", True),
         console_logging=flux.get("console_logging", False),
         jitter_enabled=flux.get("jitter_enabled", False),
         jitter_max_ms=flux.get("jitter_max_ms", 1000),
+        hot_key_shards=flux.get("hot_key_shards", 0),
+        hot_key_threshold=flux.get("hot_key_threshold", 5000),
         analytics_enabled=analytics.get("enabled", False),
         analytics_port=analytics.get("port", 4444),
         analytics_stream=analytics.get("stream", "flux:events"),
@@ -100,7 +100,9 @@ def rate_limit(
 
         def check_limit_and_get_response(limiter, final_key, args, endpoint_name=None):
             result = limiter.hit(final_key, endpoint=endpoint_name)
-            
+            return denied_response_for(result, final_key, args)
+
+        def denied_response_for(result, final_key, args):
             if not result.allowed:
                 # ---------------------------------------------------------
                 # AUTO-RESPONSE GENERATION
@@ -167,18 +169,16 @@ def rate_limit(
             async def wrapper(*args, **kwargs):
                 limiter = get_limiter()
                 final_key = get_final_key(args, kwargs, func.__name__)
-                
-                # Check limit (Sync operation, Redis is fast enough)
-                # If we need async redis, we'd need a different client
-                denied_response = check_limit_and_get_response(
-                    limiter, 
-                    final_key, 
-                    args, 
-                    endpoint_name=name or func.__name__
+
+                # Awaitable check: the Redis round trip runs on a C++ worker
+                # thread and the event loop keeps serving other requests.
+                result = await limiter.hit_async(
+                    final_key, endpoint=name or func.__name__
                 )
+                denied_response = denied_response_for(result, final_key, args)
                 if denied_response:
                     return denied_response
-                
+
                 return await func(*args, **kwargs)
             return wrapper
         
@@ -6,7 +6,7 @@ from pathlib import Path
 from typing import Optional, Tuple, List, Callable, Dict, Any, Union
 from dataclasses import dataclass
 
-from ._flux_core import RedisClient
+from ._flux_core import RedisClient, LocalLimiter
 from .config import get_config, FluxConfig, RateLimitPolicy, RateLimitDefaults
 from .exceptions import RateLimitExceeded, ConnectionError
 from .analytics import AnalyticsServer
@@ -34,6 +34,7 @@ def _get_script(policy: RateLimitPolicy) -> Tuple[str, str]:
             RateLimitPolicy.TOKEN_BUCKET: "token_bucket.lua",
             RateLimitPolicy.LEAKY_BUCKET: "leaky_bucket.lua",
             RateLimitPolicy.FIXED_WINDOW: "fcfs.lua",
+            RateLimitPolicy.SLIDING_WINDOW: "sliding_window.lua",
         }
         
         script_name = script_map.get(policy)
@@ -102,7 +103,7 @@ class RateLimitResult:
 class RateLimiter:
     """
     Framework-agnostic rate limiter using Redis.
-    Supports: GCRA, Token Bucket, Leaky Bucket, Fixed Window.
+    Supports: GCRA, Token Bucket, Leaky Bucket, Fixed Window, Sliding Window.
     """
     
     def __init__(
@@ -114,6 +115,7 @@ class RateLimiter:
         policy: Optional[Union[RateLimitPolicy, str]] = None,
         redis_host: Optional[str] = None,
         redis_port: Optional[int] = None,
+        backend: Optional[str] = None,
         config: Optional[FluxConfig] = None,
     ):
         """
@@ -153,7 +155,20 @@ class RateLimiter:
                 raise ValueError(f"Invalid policy name: {policy}")
                 
         self.policy = policy or self._config.policy
-        
+
+        # Backend: "redis" (default) or "local" (embedded engine, no Redis)
+        self.backend = (backend or getattr(self._config, "backend", "redis")).lower()
+        if self.backend not in ("redis", "local"):
+            raise ValueError(f"Invalid backend: {self.backend}")
+        if self.backend == "local" and self.policy not in (
+            RateLimitPolicy.GCRA,
+            RateLimitPolicy.TOKEN_BUCKET,
+        ):
+            raise ValueError(
+                f"Local backend supports gcra and token_bucket, not {self.policy.value}"
+            )
+        self._local: Optional[LocalLimiter] = None
+
         # Redis config (use provided values or from config)
         self._redis_config = {
             "host": redis_host or self._config.redis_host,
@@ -161,18 +176,28 @@ class RateLimiter:
             "pool_size": self._config.pool_size,
             "timeout_ms": self._config.timeout_ms,
             "log_file": self._config.log_file,
+            "unix_socket_path": self._config.unix_socket_path,
         }
         
+        # The client property reads these, so they must exist before the
+        # analytics block below touches it.
+        self._client = None
+        self._script_content: Optional[str] = None
+        self._script_sha: Optional[str] = None
+
         # Initialize Analytics Server if enabled (Singleton)
         if self._config.analytics_enabled:
             # We need a StatsProvider. It needs a Redis client.
             # We can use the same redis-py client we use for metrics.
-            provider = StatsProvider(self.metrics_client, self._config.key_prefix)
+            try:
+                # Route stats reads through the C++ tracking cache when the
+                # core client is usable; falls back to redis-py otherwise.
+                # This same instance keeps serving hit() afterwards.
+                core = self.client
+            except ConnectionError:
+                core = None
+            provider = StatsProvider(self.metrics_client, self._config.key_prefix, core_client=core)
             self.analytics = self._get_analytics_server(self._config, provider)
-        
-        self._client = None
-        self._script_content: Optional[str] = None
-        self._script_sha: Optional[str] = None
     
     @classmethod
     def from_config(cls, name: str, config: Optional[FluxConfig] = None) -> "RateLimiter":
@@ -218,7 +243,40 @@ class RateLimiter:
                     self._redis_config["timeout_ms"],
                     self._redis_config["log_file"],
                     self._config.console_logging,
+                    unix_socket_path=self._redis_config["unix_socket_path"],
+                    circuit_fail_open=self._config.fail_silently,
+                    thread_affinity=self._config.thread_affinity,
                 )
+                # Register the policy script once so per-call paths can use
+                # eval_by_name instead of shipping the script body each time.
+                try:
+                    content, _ = self.script
+                    self._client.register_script(self.policy.value, content)
+                except Exception:
+                    pass  # NOSCRIPT fallback in eval_script still covers us
+                if self._config.hot_key_shards > 0:
+                    # Fan viral keys out across N sub-keys; detection runs in
+                    # the C++ core, so no per-key configuration is needed.
+                    try:
+                        rebalance = (
+                            Path(__file__).parent / "lua" / "shard_rebalance.lua"
+                        ).read_text()
+                    except OSError:
+                        rebalance = ""
+                    try:
+                        self._client.enable_hot_key_sharding(
+                            self._config.hot_key_shards,
+                            self._config.hot_key_threshold,
+                            self.policy.value,
+                            rebalance,
+                        )
+                    except Exception:
+                        pass  # sharding is an optimization, never fatal
+                if self._config.analytics_enabled:
+                    self._client.enable_analytics(
+                        self._config.analytics_stream,
+                        self._config.analytics_retention,
+                    )
             except ImportError:
                 raise ConnectionError("Flux C++ core not found. Run 'pip install .'")
             except RuntimeError as e:
@@ -292,43 +350,42 @@ class RateLimiter:
             keys.append(f"{full_key}:queue")
             window_ms = self.period * 1000
             args = [self.requests, window_ms, now_ms]
-            
+
+        elif self.policy == RateLimitPolicy.SLIDING_WINDOW:
+            window_ms = self.period * 1000
+            args = [self.requests, window_ms, now_ms]
+
+
         else:
             raise ValueError(f"Unsupported policy: {self.policy}")
 
-        # Analytics Arguments (if enabled)
-        # KEYS: [1]... [2] stats_ep_key, [3] stats_global_key, [4] stats_ep_set
-        # ARGV: ... [4] record_analytics, [5] endpoint_name, [6] meta_requests ...
-        
-        if self._config.analytics_enabled and endpoint:
-            # Sampling Check
-            # If sample_rate < 1.0, we probabilistically skip analytics
-            record_analytics = 1
-            if self._config.analytics_sample_rate < 1.0:
-                if random.random() > self._config.analytics_sample_rate:
-                    record_analytics = 0
-            
-            # If skipping, we effectively pass 0 unless we want to "send but flag".
-            # The most efficient way is to send 0 so Lua skips XADD entirely.
-            
-            if record_analytics == 1:
-                keys.append(self._config.analytics_stream)
-                
-                args.append(1) # record_analytics = true
-                args.append(endpoint)
-                args.append(self.requests)
-                args.append(self.period)
-                args.append(self.burst)
-                args.append(self.policy.value)
-                args.append(self._config.analytics_retention) # maxlen
-            else:
-                 # Sampled out
-                 args.append(0)
-        else:
-            # Pass 0 to indicate no analytics
-            args.append(0)
-            
+        # Analytics are no longer passed to the scripts: the decision comes
+        # back alone and _record_analytics hands the event to the C++
+        # background batcher, fully off the request path.
+
         return keys, args
+
+    def _record_analytics(self, hashed_key: str, endpoint: str, allowed: bool, usage: int):
+        """Enqueue an analytics event into the C++ background XADD batcher."""
+        if not (self._config.analytics_enabled and endpoint):
+            return
+        # Probabilistic sampling, same semantics the Lua path had
+        if self._config.analytics_sample_rate < 1.0:
+            if random.random() > self._config.analytics_sample_rate:
+                return
+        try:
+            self.client.record_analytics_event(
+                hashed_key,
+                endpoint,
+                allowed,
+                self.policy.value,
+                usage,
+                self.requests,
+                self.period,
+                self.burst or 0,
+            )
+        except Exception:
+            pass  # analytics are best-effort
     
     def _parse_result(self, status: int, value: Union[int, list], now_ms: int) -> RateLimitResult:
         """Parse the result from the Lua script."""
@@ -386,6 +443,25 @@ class RateLimiter:
                 _ANALYTICS_SERVER = None
         return _ANALYTICS_SERVER
 
+    def _hit_local(self, key: str, now_ms: int) -> RateLimitResult:
+        """Check against the embedded C++ engine (LocalLimiter, no Redis)."""
+        if self._local is None:
+            self._local = LocalLimiter()
+
+        if self.policy == RateLimitPolicy.GCRA:
+            emission_interval_ms = int((self.period * 1000) / self.requests)
+            delay_tolerance_ms = emission_interval_ms * self.burst
+            response = self._local.check_gcra(
+                key, emission_interval_ms, delay_tolerance_ms, now_ms
+            )
+        else:  # TOKEN_BUCKET (validated in __init__)
+            refill_time_ms = int((self.period * 1000) / self.requests)
+            response = self._local.check_token_bucket(
+                key, self.burst, refill_time_ms, now_ms
+            )
+
+        return self._parse_result(int(response[0]), list(response), now_ms)
+
     def hit(self, key: str, endpoint: Optional[str] = None) -> RateLimitResult:
         """
         Record a request and check if allowed.
@@ -401,8 +477,12 @@ class RateLimiter:
             RateLimitResult with allowed status
         """
         now_ms = self._now_ms()
-        
+
         try:
+            # Embedded backend: answered entirely in-process by the C++ engine
+            if self.backend == "local":
+                return self._hit_local(key, now_ms)
+
             # Measure time
             start_time = time.time()
 
@@ -458,12 +538,14 @@ class RateLimiter:
             # print(f"[debug] redis response: {response}") 
 
             result = self._parse_result(int(status), value, now_ms)
-            
+
             # Duration calculation is no longer used for metrics in Lua (captured as count only)
             # duration_ms = (time.time() - start_time) * 1000.0
 
-            # Metrics are now recorded INSIDE the Lua script (1 RTT)
-                
+            # Analytics: enqueue into the C++ background batcher (off-path)
+            usage = int(value[2]) if isinstance(value, list) and len(value) > 2 else 0
+            self._record_analytics(final_keys[0], endpoint, result.allowed, usage)
+
             return result
         
         except Exception as e:
@@ -473,7 +555,7 @@ class RateLimiter:
                 print(f"[flux] [error] Rate limit check failed (Fail Open active): {e}", file=sys.stderr)
                 import traceback
                 traceback.print_exc()
-                
+
                 return RateLimitResult(
                     allowed=True,
                     remaining=1,
@@ -484,6 +566,70 @@ class RateLimiter:
                 # Fail Closed: Re-raise exception
                 raise ConnectionError(f"Rate limit check failed: {e}")
 
+    async def hit_async(self, key: str, endpoint: Optional[str] = None) -> RateLimitResult:
+        """
+        Asyncio-native hit(): awaits the check without blocking the event loop.
+
+        The C++ core runs the Redis round trip on a worker thread and
+        completes an asyncio Future via call_soon_threadsafe, so a single
+        uvicorn worker can keep serving other requests for the full RTT.
+        Semantics match hit(): same scripts, same fail-open behaviour.
+        """
+        now_ms = self._now_ms()
+
+        try:
+            # Embedded backend answers in-process in microseconds; nothing to
+            # await.
+            if self.backend == "local":
+                return self._hit_local(key, now_ms)
+
+            keys, args = self._build_script_params(key, now_ms, endpoint)
+            prefix = self._config.key_prefix
+
+            # The C++ engine hashes and prefixes the keys itself on this
+            # path. The script was registered once when the client was
+            # built, so the per-call payload carries its name only — never
+            # the script body.
+            try:
+                response = await self.client.eval_by_name_async(
+                    self.policy.value, keys, args, prefix
+                )
+            except RuntimeError as e:
+                if "Unknown script" not in str(e):
+                    raise
+                # Registration failed at startup (e.g. Redis was briefly
+                # down): re-register and fall back to the payload path,
+                # which self-heals NOSCRIPT.
+                content, sha1 = self.script
+                try:
+                    self.client.register_script(self.policy.value, content)
+                except Exception:
+                    pass
+                response = await self.client.eval_script_async(
+                    sha1, content, keys, args, prefix
+                )
+
+            result = self._parse_result(int(response[0]), list(response), now_ms)
+
+            usage = int(response[2]) if len(response) > 2 else 0
+            hashed_key = f"{prefix}{hashlib.sha256(key.encode()).hexdigest()}"
+            self._record_analytics(hashed_key, endpoint, result.allowed, usage)
+
+            return result
+
+        except Exception as e:
+            if self._config.fail_silently:
+                import sys
+                print(f"[flux] [error] Rate limit check failed (Fail Open active): {e}", file=sys.stderr)
+                return RateLimitResult(
+                    allowed=True,
+                    remaining=1,
+                    retry_after=0,
+                    limit=self.requests
+                )
+            else:
+                raise ConnectionError(f"Rate limit check failed: {e}")
+
 
 def preload_scripts(config: Optional[FluxConfig] = None):
     """
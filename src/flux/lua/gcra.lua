@@ -13,12 +13,9 @@ local emission_interval = tonumber(ARGV[1])
 local delay_variation_tolerance = tonumber(ARGV[2])
 local now = tonumber(ARGV[3]) -- Current timestamp in milliseconds
 
--- Get current TAT (Theoretical Arrival Time)
--- Analytics Argv indices
--- KEYS: [1] limit_key, [2] stream_key
--- ARGV: [1] emission, [2] tolerance, [3] now, [4] record_analytics, [5] ep, [6-9] meta... [10] retention
+-- Analytics are recorded off the request path by the C++ batcher
+-- (analytics_batcher.cpp); this script returns the decision only.
 
-local record_analytics = tonumber(ARGV[4]) or 0
 local decision_allowed = 0
 local return_val = 0 -- tat or retry_after
 local current_usage = 0
@@ -51,26 +48,6 @@ else
     current_usage = math.max(0, new_tat - now)
 end
 
--- Analytics Recording
--- Analytics Recording
-if record_analytics == 1 then
-    local stream_key = KEYS[2]
-    local endpoint = ARGV[5]
-    local max_len = ARGV[10]
-    
-    redis.call('XADD', stream_key, 'MAXLEN', '~', max_len, '*',
-        'ts', now,
-        'key', KEYS[1],
-        'ep', endpoint,
-        'd', decision_allowed,
-        'p', 'gcra',
-        'u', current_usage,
-        'mr', ARGV[6], -- requests
-        'mp', ARGV[7], -- period
-        'mb', ARGV[8]  -- burst
-    )
-end
-
 if decision_allowed == 1 then
     return {0, return_val, current_usage}
 else
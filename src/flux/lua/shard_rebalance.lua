@@ -0,0 +1,59 @@
+-- Shard Rebalancer for hot-key sharding
+-- Parameters:
+--   KEYS[1..N]: the N shard keys of one hot base key
+--   ARGV[1]: state field to even out ('tokens' for token_bucket, 'level'
+--            for leaky_bucket, '' for plain string state such as the GCRA
+--            TAT or the fixed-window counter)
+-- Returns:
+--   number of shards rewritten (0 if fewer than two shards have state)
+--
+-- Each shard runs at rate/N, so uneven shard selection slowly skews the
+-- shards apart: one shard denies while its siblings sit on spare capacity.
+-- This script pulls every shard back to the mean, so the fanned-out limit
+-- keeps behaving like one limit of the full rate. Only used by the
+-- single-instance client: shard keys hash to different cluster slots by
+-- design, which rules out one multi-key script invocation on a cluster.
+
+local field = ARGV[1]
+
+local vals = {}
+local sum = 0
+local found = 0
+
+for i, key in ipairs(KEYS) do
+    local v
+    if field == '' then
+        v = redis.call('GET', key)
+    else
+        v = redis.call('HGET', key, field)
+    end
+    if v then
+        vals[i] = tonumber(v)
+        sum = sum + vals[i]
+        found = found + 1
+    end
+end
+
+-- Nothing to even out: untouched shards initialise themselves on first use.
+if found < 2 then
+    return 0
+end
+
+local mean = sum / found
+local rewritten = 0
+
+for i, key in ipairs(KEYS) do
+    if vals[i] then
+        if field == '' then
+            -- Plain string state is integral (GCRA TAT in ms, fixed-window
+            -- count) and fcfs.lua INCRs its key, which aborts on a
+            -- fractional string — floor the mean before writing it back.
+            redis.call('SET', key, math.floor(mean), 'KEEPTTL')
+        else
+            redis.call('HSET', key, field, mean)
+        end
+        rewritten = rewritten + 1
+    end
+end
+
+return rewritten
@@ -0,0 +1,64 @@
+-- Sliding Window Counter Rate Limiter
+-- Parameters:
+--   KEYS[1]: rate limit key (stores cur, prev and win bucket fields)
+--   ARGV[1]: limit (max requests per window)
+--   ARGV[2]: window_ms (window length in milliseconds)
+--   ARGV[3]: now (current timestamp in milliseconds)
+-- Returns:
+--   -1 if rate limit exceeded (with retry_after in seconds)
+--   Remaining requests if allowed
+--
+-- Two rotating buckets per key: the count for the current window and the
+-- count for the previous one. The effective usage is the current count plus
+-- the previous count weighted by how much of the previous window still
+-- overlaps the sliding window ending now — one HMGET, one HMSET, O(1) state,
+-- and the usage value doubles as "requests in the last window" for quota
+-- reporting.
+
+local key = KEYS[1]
+local limit = tonumber(ARGV[1])
+local window_ms = tonumber(ARGV[2])
+local now = tonumber(ARGV[3])
+
+local idx = math.floor(now / window_ms)
+local elapsed = now % window_ms
+
+-- Analytics are recorded off the request path by the C++ batcher
+-- (analytics_batcher.cpp); this script returns the decision only.
+
+local data = redis.call('HMGET', key, 'cur', 'prev', 'win')
+local cur = tonumber(data[1]) or 0
+local prev = tonumber(data[2]) or 0
+local win = tonumber(data[3])
+
+-- Rotate the buckets forward to the window containing `now`.
+if win ~= idx then
+    if win == idx - 1 then
+        prev = cur
+    else
+        prev = 0
+    end
+    cur = 0
+end
+
+-- Weighted interpolation: the share of the previous window still inside
+-- the sliding window [now - window_ms, now].
+local weight = (window_ms - elapsed) / window_ms
+local usage = math.floor(cur + prev * weight)
+
+if usage < limit then
+    cur = cur + 1
+    redis.call('HMSET', key, 'cur', cur, 'prev', prev, 'win', idx)
+    redis.call('PEXPIRE', key, window_ms * 2)
+    return {0, limit - usage - 1, usage + 1}
+else
+    -- The weighted count shrinks as the previous window slides out; the
+    -- remainder of the current window is the upper bound on the wait.
+    local retry_after = math.ceil((window_ms - elapsed) / 1000)
+    if retry_after < 1 then
+        retry_after = 1
+    end
+    redis.call('HMSET', key, 'cur', cur, 'prev', prev, 'win', idx)
+    redis.call('PEXPIRE', key, window_ms * 2)
+    return {-1, retry_after, usage}
+end
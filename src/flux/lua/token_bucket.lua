@@ -15,13 +15,8 @@ local now = tonumber(ARGV[3])
 
 local refill_rate = 1000.0 / refill_time_ms
 
--- Get current state: tokens and last_refill_time
--- Analytics args (indices shift based on Keys)
--- Analytics args (indices shift based on Keys)
--- KEYS: [1] limit_key, [2] stream_key
--- ARGV: [1] capacity, [2] refill_time_ms, [3] now, [4] record_analytics (0/1), [5] endpoint_name, [6-9] meta..., [10] retention(maxlen)
-
-local record_analytics = tonumber(ARGV[4]) or 0
+-- Analytics are recorded off the request path by the C++ batcher
+-- (analytics_batcher.cpp); this script returns the decision only.
 
 -- Rate Limit Logic
 local decision_allowed = 0
@@ -70,30 +65,6 @@ else
     redis.call('EXPIRE', key, ttl)
 end
 
--- Analytics Recording
--- Analytics Recording
-if record_analytics == 1 then
-    local stream_key = KEYS[2]
-    local endpoint = ARGV[5]
-    local max_len = ARGV[10] -- Was ttl, now reuse slot for max_len (or just hardcode/pass new arg)
-    -- Actually ARGV indices might need to drift if we change python side.
-    -- Plan says: "Update ARGV mapping". Let's assume Python sends the right things.
-    -- Python changes will map:
-    -- ARGV[10] -> retention (maxlen)
-    
-    redis.call('XADD', stream_key, 'MAXLEN', '~', max_len, '*',
-        'ts', now,
-        'key', KEYS[1],
-        'ep', endpoint,
-        'd', decision_allowed,
-        'p', 'token_bucket',
-        'u', current_usage,
-        'mr', ARGV[6], -- requests
-        'mp', ARGV[7], -- period
-        'mb', ARGV[8]  -- burst
-    )
-end
-
 if decision_allowed == 1 then
      return {0, return_val, current_usage}
 else
@@ -0,0 +1,51 @@
+-- Token Lease: batch reservation on top of a token bucket
+-- Parameters:
+--   KEYS[1]: rate limit key (stores tokens and last_refill_time)
+--   ARGV[1]: capacity (max tokens/burst)
+--   ARGV[2]: refill_time_ms (milliseconds per token)
+--   ARGV[3]: now (current timestamp in milliseconds)
+--   ARGV[4]: batch (number of tokens the caller wants to lease)
+-- Returns:
+--   {granted, retry_after_s, current_usage}
+--   granted: how many tokens were actually reserved (0..batch). The caller
+--   serves that many checks locally before coming back for another lease.
+--   Tokens leased by a process that dies are not returned; the bucket
+--   refills them over time, so enforcement is approximate by design.
+
+local key = KEYS[1]
+local capacity = tonumber(ARGV[1])
+local refill_time_ms = tonumber(ARGV[2])
+local now = tonumber(ARGV[3])
+local batch = tonumber(ARGV[4])
+
+local refill_rate = 1000.0 / refill_time_ms
+
+-- Get current state: tokens and last_refill_time
+local data = redis.call('HMGET', key, 'tokens', 'last_refill')
+local tokens = tonumber(data[1]) or capacity
+local last_refill = tonumber(data[2]) or now
+
+-- Refill tokens based on elapsed time
+local elapsed_seconds = (now - last_refill) / 1000.0
+if elapsed_seconds > 0 then
+    local tokens_to_add = math.floor(elapsed_seconds * refill_rate)
+    tokens = math.min(capacity, tokens + tokens_to_add)
+    last_refill = now
+end
+
+-- Reserve as much of the requested batch as is available
+local granted = math.min(tokens, batch)
+tokens = tokens - granted
+local current_usage = capacity - tokens
+
+redis.call('HMSET', key, 'tokens', tokens, 'last_refill', last_refill)
+local ttl = math.ceil((capacity / refill_rate) * 2)
+redis.call('EXPIRE', key, ttl)
+
+local retry_after = 0
+if granted == 0 then
+    local time_until_next_token = math.ceil((1.0 / refill_rate) * 1000) -- in milliseconds
+    retry_after = math.ceil(time_until_next_token / 1000) -- in seconds
+end
+
+return {granted, retry_after, current_usage}
@@ -3,10 +3,14 @@ from typing import List, Dict, Any
 from .config import get_config
 
 class StatsProvider:
-    def __init__(self, redis_client=None, key_prefix="flux:"):
+    def __init__(self, redis_client=None, key_prefix="flux:", core_client=None):
         self.config = get_config()
         self.key_prefix = key_prefix
-        
+        # Optional _flux_core.RedisClient: when present, reads go through its
+        # RESP3 CLIENT TRACKING cache and are served in-process between
+        # invalidations instead of hitting Redis every refresh tick.
+        self.core = core_client
+
         if redis_client:
             self.r = redis_client
         else:
@@ -16,34 +20,59 @@ class StatsProvider:
                 decode_responses=True,
                 socket_timeout=1.0,
             )
-        
+
+    def _smembers(self, key):
+        if self.core is not None:
+            return set(self.core.read_cached("SMEMBERS", key))
+        return self.r.smembers(key)
+
+    def _hgetall_many(self, keys):
+        if self.core is not None:
+            results = []
+            for key in keys:
+                flat = self.core.read_cached("HGETALL", key)
+                results.append(dict(zip(flat[::2], flat[1::2])))
+            return results
+        pipe = self.r.pipeline()
+        for key in keys:
+            pipe.hgetall(key)
+        return pipe.execute()
+
+    def get_core_metrics(self) -> Dict[str, int]:
+        """Snapshot the C++ core's lock-free counters and latency percentiles.
+
+        Empty when no core client is attached (pure redis-py setups). The
+        snapshot never touches Redis, so it is safe for Prometheus-style
+        scraping at any rate.
+        """
+        if self.core is None:
+            return {}
+        try:
+            return dict(self.core.get_metrics())
+        except Exception:
+            return {}
+
     def get_stats(self) -> List[Dict[str, Any]]:
         prefix = self.key_prefix
         endpoint_key = f"{prefix}stats:endpoints"
-        
+
         try:
-            endpoints = self.r.smembers(endpoint_key)
+            endpoints = self._smembers(endpoint_key)
         except Exception:
             # Return empty if Redis is down
             return []
-        
+
         if not endpoints:
             return []
-            
+
         sorted_endpoints = sorted(list(endpoints))
-        
-        # Use pipeline for efficiency
-        pipe = self.r.pipeline()
-        
-        # 1. Get Latency Stats (Global)
-        pipe.hgetall(f"{prefix}stats:global")
-        
-        # 2. Get Endpoint Stats (All in one HGETALL per endpoint)
-        for ep in sorted_endpoints:
-            pipe.hgetall(f"{prefix}stats:ep:{ep}")
-            
+
+        # Global latency stats first, then one HGETALL per endpoint
+        hash_keys = [f"{prefix}stats:global"]
+        hash_keys.extend(f"{prefix}stats:ep:{ep}" for ep in sorted_endpoints)
+
         try:
-            values = pipe.execute()
+            values = self._hgetall_many(hash_keys)
         except Exception:
             return []
         
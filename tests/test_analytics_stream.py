@@ -21,6 +21,20 @@ def clean_redis(redis_client):
     redis_client.flushdb()
     return redis_client
 
+
+def wait_for_entries(r, stream, count, timeout=2.0):
+    """Analytics events are flushed by the C++ background batcher (every
+    20ms / 512 events), not synchronously from hit(); poll until the
+    expected entries land."""
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        entries = r.xrange(stream)
+        if len(entries) >= count:
+            return entries
+        time.sleep(0.05)
+    return r.xrange(stream)
+
+
 def test_analytics_stream_emission(clean_redis):
     # 1. Setup Config
     config = FluxConfig(
@@ -35,9 +49,9 @@ def test_analytics_stream_emission(clean_redis):
     
     # 3. Hit
     limiter.hit("user_123", endpoint="test_ep")
-    
-    # 4. Verify Stream
-    entries = clean_redis.xrange("test:events")
+
+    # 4. Verify Stream (batcher flushes in the background)
+    entries = wait_for_entries(clean_redis, "test:events", 1)
     assert len(entries) == 1
     
     msg_id, data = entries[0]
@@ -67,7 +81,10 @@ def test_analytics_worker_consumption(clean_redis):
     # 3. Generate Traffic (Allowed)
     limiter.hit("user_a", endpoint="api_v1")
     limiter.hit("user_a", endpoint="api_v1")
-    
+
+    # Wait for the background batcher to flush both events
+    wait_for_entries(clean_redis, config.analytics_stream, 2)
+
     # 4. Process manually (avoid threading in test for determinism)
     # Ensure group exists
     worker._ensure_group()
@@ -116,7 +133,10 @@ def test_analytics_worker_blocked_request(clean_redis):
     limiter.hit("user_b", endpoint="api_blocked")
     # 3. Hit (Blocked)
     limiter.hit("user_b", endpoint="api_blocked")
-    
+
+    # Wait for the background batcher to flush both events
+    wait_for_entries(clean_redis, config.analytics_stream, 2)
+
     # 4. Process
     entries = clean_redis.xreadgroup(
         worker.group_name, 
@@ -2,6 +2,7 @@ import pytest
 import threading
 import time
 import subprocess
+import hashlib
 import os
 import sys
 from unittest.mock import MagicMock
@@ -133,3 +134,136 @@ class TestJitterLogic:
         limiter = RateLimiter(requests=1, period=10, config=config)
         res = limiter._parse_result(1, 10.0, 0)
         assert res.retry_after == 10.0
+
+
+# ------------------------------------------------------------------
+# SCRIPT REGISTRY TESTS
+# ------------------------------------------------------------------
+class TestScriptRegistry:
+    def test_eval_by_name_roundtrip(self, redis_client):
+        script = "return {0, tonumber(ARGV[1]), 2}"
+        sha = redis_client.register_script("registry_test_script", script)
+        assert len(sha) == 40
+
+        result = redis_client.eval_by_name(
+            "registry_test_script", ["registry:test:key"], [7]
+        )
+        assert result == [0, 7, 2]
+
+    def test_reregister_replaces_entry(self, redis_client):
+        redis_client.register_script("registry_swap", "return {0, 1, 0}")
+        redis_client.register_script("registry_swap", "return {0, 2, 0}")
+        result = redis_client.eval_by_name("registry_swap", ["registry:swap"], [])
+        assert result == [0, 2, 0]
+
+    def test_unknown_name_raises(self, redis_client):
+        with pytest.raises(RuntimeError, match="Unknown script"):
+            redis_client.eval_by_name("never_registered", ["registry:none"], [1])
+
+
+# ------------------------------------------------------------------
+# BATCH EVAL TESTS
+# ------------------------------------------------------------------
+class TestBatchEval:
+    def test_results_come_back_in_call_order(self, redis_client):
+        content = "return {0, tonumber(ARGV[1]), 0}"
+        sha = hashlib.sha1(content.encode()).hexdigest()
+
+        calls = [([f"batch:key:{i}"], [i]) for i in range(5)]
+        results = redis_client.eval_script_batch(sha, content, calls)
+
+        assert results == [[0, i, 0] for i in range(5)]
+
+    def test_empty_batch(self, redis_client):
+        content = "return {0, 0, 0}"
+        sha = hashlib.sha1(content.encode()).hexdigest()
+        assert redis_client.eval_script_batch(sha, content, []) == []
+
+    def test_noscript_self_heals(self, redis_client):
+        # A batch against a never-loaded script must reload and still answer
+        content = "return {0, 42, 0}"
+        sha = hashlib.sha1(content.encode()).hexdigest()
+        results = redis_client.eval_script_batch(sha, content, [(["batch:heal"], [])])
+        assert results == [[0, 42, 0]]
+
+
+# ------------------------------------------------------------------
+# DENIAL CACHE TESTS
+# ------------------------------------------------------------------
+class TestDenialCache:
+    def test_repeat_denial_served_locally(self, redis_client):
+        content = "return {-1, 5, 1}"
+        sha = hashlib.sha1(content.encode()).hexdigest()
+
+        first = redis_client.eval_script(sha, content, ["denial:cached"], [])
+        assert first == [-1, 5, 1]
+
+        # A cached answer carries usage 0 and a remaining deadline bounded
+        # by the original retry_after: proof the verdict never left the
+        # process, since the script itself always reports usage 1.
+        second = redis_client.eval_script(sha, content, ["denial:cached"], [])
+        assert second[0] == -1
+        assert 1 <= second[1] <= 5
+        assert second[2] == 0
+
+    def test_allows_are_not_cached(self, redis_client):
+        content = "return {0, tonumber(ARGV[1]), 1}"
+        sha = hashlib.sha1(content.encode()).hexdigest()
+
+        assert redis_client.eval_script(sha, content, ["denial:allowed"], [1]) == [0, 1, 1]
+        # Second call reaches the script again: a changed ARGV shows up
+        assert redis_client.eval_script(sha, content, ["denial:allowed"], [2]) == [0, 2, 1]
+
+    def test_disabled_cache_always_reaches_redis(self):
+        try:
+            client = RedisClient(REDIS_HOST, REDIS_PORT, enable_denial_cache=False)
+        except RuntimeError:
+            pytest.skip("Redis not available")
+
+        content = "return {-1, 5, 1}"
+        sha = hashlib.sha1(content.encode()).hexdigest()
+        assert client.eval_script(sha, content, ["denial:nocache"], []) == [-1, 5, 1]
+        assert client.eval_script(sha, content, ["denial:nocache"], []) == [-1, 5, 1]
+
+
+# ------------------------------------------------------------------
+# CORE METRICS TESTS
+# ------------------------------------------------------------------
+class TestCoreMetrics:
+    def test_counters_track_verdicts(self, redis_client):
+        allow = "return {0, 1, 1}"
+        allow_sha = hashlib.sha1(allow.encode()).hexdigest()
+        deny = "return {-1, 5, 1}"
+        deny_sha = hashlib.sha1(deny.encode()).hexdigest()
+
+        for i in range(3):
+            redis_client.eval_script(allow_sha, allow, [f"metrics:a:{i}"], [])
+        redis_client.eval_script(deny_sha, deny, ["metrics:d"], [])
+
+        m = redis_client.get_metrics()
+        assert m["checks"] == 4
+        assert m["allows"] == 3
+        assert m["denies"] == 1
+
+    def test_histograms_record_each_eval(self, redis_client):
+        content = "return {0, 1, 1}"
+        sha = hashlib.sha1(content.encode()).hexdigest()
+        for i in range(5):
+            redis_client.eval_script(sha, content, [f"metrics:h:{i}"], [])
+
+        m = redis_client.get_metrics()
+        assert m["eval_count"] == 5
+        # NOSCRIPT reloads on a cold script cache add extra checkouts
+        assert m["checkout_count"] >= 5
+        # Percentiles are upper bucket edges, so p50 <= p99 <= recorded max
+        assert 0 < m["eval_p50_us"] <= m["eval_p99_us"]
+        assert m["eval_max_us"] >= 1
+
+    def test_snapshot_contains_all_series(self, redis_client):
+        m = redis_client.get_metrics()
+        for name in ("checks", "allows", "denies", "retries",
+                     "noscript_reloads", "pool_waits",
+                     "eval_count", "eval_p50_us", "eval_p90_us",
+                     "eval_p99_us", "eval_p999_us", "eval_max_us",
+                     "checkout_count", "checkout_p50_us", "checkout_max_us"):
+            assert name in m
@@ -0,0 +1,84 @@
+import os
+import sys
+
+# Add src to path
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '../src')))
+
+from flux._flux_core import LocalLimiter
+
+# The caller supplies now_ms, so every outcome here is fully deterministic:
+# no Redis, no sleeps, no wall clock.
+NOW = 1_000_000
+
+
+class TestLocalGcra:
+    def test_first_request_allowed(self):
+        limiter = LocalLimiter()
+        status, new_tat, usage = limiter.check_gcra("k", 1000, 3000, NOW)
+        assert status == 0
+        assert new_tat == NOW + 1000
+        assert usage == 1000
+
+    def test_burst_then_deny(self):
+        limiter = LocalLimiter()
+        # tolerance = 3 * emission: exactly three back-to-back requests fit
+        for _ in range(3):
+            assert limiter.check_gcra("k", 1000, 3000, NOW)[0] == 0
+
+        status, retry_after, usage = limiter.check_gcra("k", 1000, 3000, NOW)
+        assert status == -1
+        assert retry_after == 1  # one emission interval away, rounded up
+        assert usage == 3000
+
+    def test_recovers_as_time_passes(self):
+        limiter = LocalLimiter()
+        for _ in range(3):
+            limiter.check_gcra("k", 1000, 3000, NOW)
+        assert limiter.check_gcra("k", 1000, 3000, NOW)[0] == -1
+
+        # One emission interval later a slot has drained
+        assert limiter.check_gcra("k", 1000, 3000, NOW + 1000)[0] == 0
+
+    def test_keys_are_independent(self):
+        limiter = LocalLimiter()
+        for _ in range(3):
+            limiter.check_gcra("a", 1000, 3000, NOW)
+        assert limiter.check_gcra("a", 1000, 3000, NOW)[0] == -1
+        assert limiter.check_gcra("b", 1000, 3000, NOW)[0] == 0
+
+
+class TestLocalTokenBucket:
+    def test_drain_and_deny(self):
+        limiter = LocalLimiter()
+        assert limiter.check_token_bucket("k", 2, 1000, NOW) == [0, 1, 1]
+        assert limiter.check_token_bucket("k", 2, 1000, NOW) == [0, 0, 2]
+
+        status, retry_after, usage = limiter.check_token_bucket("k", 2, 1000, NOW)
+        assert status == -1
+        assert retry_after == 1
+        assert usage == 2
+
+    def test_refill_after_interval(self):
+        limiter = LocalLimiter()
+        limiter.check_token_bucket("k", 2, 1000, NOW)
+        limiter.check_token_bucket("k", 2, 1000, NOW)
+        assert limiter.check_token_bucket("k", 2, 1000, NOW)[0] == -1
+
+        # One refill interval later exactly one token is back
+        assert limiter.check_token_bucket("k", 2, 1000, NOW + 1000) == [0, 0, 2]
+        assert limiter.check_token_bucket("k", 2, 1000, NOW + 1000)[0] == -1
+
+    def test_tokens_cap_at_capacity(self):
+        limiter = LocalLimiter()
+        limiter.check_token_bucket("k", 2, 1000, NOW)
+        # A long idle stretch must not bank more than `capacity` tokens
+        assert limiter.check_token_bucket("k", 2, 1000, NOW + 60_000) == [0, 1, 1]
+
+    def test_expired_state_starts_fresh(self):
+        limiter = LocalLimiter()
+        limiter.check_token_bucket("k", 1, 1000, NOW)
+        assert limiter.check_token_bucket("k", 1, 1000, NOW)[0] == -1
+
+        # Past the entry's TTL (capacity/rate * 2) the stored state is
+        # ignored, mirroring the PX expiry the Lua script sets.
+        assert limiter.check_token_bucket("k", 1, 1000, NOW + 10_000)[0] == 0
@@ -0,0 +1,140 @@
+import os
+import sys
+import time
+
+import pytest
+import redis
+
+# Add src to path
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '../src')))
+
+from flux.limiter import _get_script
+from flux.config import RateLimitPolicy
+
+# ------------------------------------------------------------------
+# FIXTURES
+# ------------------------------------------------------------------
+@pytest.fixture
+def redis_client():
+    """Raw redis-py connection for driving the scripts directly."""
+    r = redis.Redis(host='localhost', port=6379, decode_responses=False)
+    try:
+        r.ping()
+    except redis.exceptions.ConnectionError:
+        pytest.skip("Redis not available")
+    return r
+
+
+def run_script(r, policy, keys, args):
+    content, _ = _get_script(policy)
+    return r.eval(content, len(keys), *keys, *args)
+
+
+# ------------------------------------------------------------------
+# FCFS / FIXED WINDOW
+# ------------------------------------------------------------------
+class TestFcfsScript:
+    """The fixed-window script must return {status, retry_after_s, usage}
+    like every other policy: the C++ denial caches treat position 2 of a
+    denial as a deadline in seconds."""
+
+    def test_allowed_returns_remaining_and_usage(self, redis_client):
+        key = "test:fcfs:allow"
+        redis_client.delete(key, f"{key}:queue")
+        now = int(time.time() * 1000)
+
+        result = run_script(redis_client, RateLimitPolicy.FIXED_WINDOW,
+                            [key, f"{key}:queue"], [3, 10_000, now])
+        assert result == [0, 2, 1]
+
+        result = run_script(redis_client, RateLimitPolicy.FIXED_WINDOW,
+                            [key, f"{key}:queue"], [3, 10_000, now])
+        assert result == [0, 1, 2]
+
+    def test_denied_returns_retry_after_not_queue_position(self, redis_client):
+        key = "test:fcfs:deny"
+        redis_client.delete(key, f"{key}:queue")
+        now = int(time.time() * 1000)
+        window_ms = 10_000
+
+        run_script(redis_client, RateLimitPolicy.FIXED_WINDOW,
+                   [key, f"{key}:queue"], [1, window_ms, now])
+
+        # Several denials in a row: a queue position would count up, a
+        # retry_after stays bounded by the window.
+        for i in range(3):
+            status, retry_after, usage = run_script(
+                redis_client, RateLimitPolicy.FIXED_WINDOW,
+                [key, f"{key}:queue"], [1, window_ms, now + i])
+            assert status == -1
+            assert 1 <= retry_after <= window_ms // 1000
+            assert usage == 1
+
+
+# ------------------------------------------------------------------
+# SLIDING WINDOW COUNTER
+# ------------------------------------------------------------------
+class TestSlidingWindowScript:
+    """Timestamps come in through ARGV, so the two-bucket interpolation is
+    fully deterministic against a real Redis."""
+
+    WINDOW_MS = 10_000
+
+    def test_fills_and_denies_within_one_window(self, redis_client):
+        key = "test:sw:fill"
+        redis_client.delete(key)
+        now = 20 * self.WINDOW_MS  # aligned to a window boundary
+
+        for i in range(3):
+            status, remaining, usage = run_script(
+                redis_client, RateLimitPolicy.SLIDING_WINDOW,
+                [key], [3, self.WINDOW_MS, now + i])
+            assert status == 0
+            assert remaining == 3 - i - 1
+            assert usage == i + 1
+
+        status, retry_after, usage = run_script(
+            redis_client, RateLimitPolicy.SLIDING_WINDOW,
+            [key], [3, self.WINDOW_MS, now + 3])
+        assert status == -1
+        assert usage == 3
+        assert 1 <= retry_after <= self.WINDOW_MS // 1000
+
+    def test_previous_window_weighs_in(self, redis_client):
+        key = "test:sw:weight"
+        redis_client.delete(key)
+        now = 20 * self.WINDOW_MS
+
+        # Fill the first window completely (limit 4)
+        for i in range(4):
+            run_script(redis_client, RateLimitPolicy.SLIDING_WINDOW,
+                       [key], [4, self.WINDOW_MS, now + i])
+
+        # 25% into the next window: weighted usage = 4 * 0.75 = 3 -> one slot
+        later = now + self.WINDOW_MS + self.WINDOW_MS // 4
+        status, remaining, usage = run_script(
+            redis_client, RateLimitPolicy.SLIDING_WINDOW,
+            [key], [4, self.WINDOW_MS, later])
+        assert (status, remaining, usage) == (0, 0, 4)
+
+        # Same instant again: cur=1 plus the weighted 3 fills the limit
+        status, _, _ = run_script(
+            redis_client, RateLimitPolicy.SLIDING_WINDOW,
+            [key], [4, self.WINDOW_MS, later])
+        assert status == -1
+
+    def test_stale_state_fully_expires(self, redis_client):
+        key = "test:sw:stale"
+        redis_client.delete(key)
+        now = 20 * self.WINDOW_MS
+
+        for i in range(4):
+            run_script(redis_client, RateLimitPolicy.SLIDING_WINDOW,
+                       [key], [4, self.WINDOW_MS, now + i])
+
+        # Two windows later the old counts contribute nothing
+        much_later = now + 2 * self.WINDOW_MS
+        status, remaining, usage = run_script(
+            redis_client, RateLimitPolicy.SLIDING_WINDOW,
+            [key], [4, self.WINDOW_MS, much_later])
+        assert (status, remaining, usage) == (0, 3, 1)
@@ -62,3 +62,38 @@ class TestExceptions:
         
         assert headers["Retry-After"] == "10"
         assert headers["X-RateLimit-Remaining"] == "0"
+
+
+class TestSlidingWindowPolicy:
+    """Pure-Python coverage of the sliding-window plumbing: script
+    parameters and result parsing, no Redis involved."""
+
+    def _limiter(self):
+        from flux.config import FluxConfig
+        return RateLimiter(requests=5, period=10, policy="sliding_window",
+                           config=FluxConfig())
+
+    def test_build_script_params(self):
+        limiter = self._limiter()
+        keys, args = limiter._build_script_params("user:1", now_ms=123_456)
+
+        assert keys == ["user:1"]  # hashing/prefixing happens in C++
+        assert args == [5, 10_000, 123_456]
+
+    def test_parse_allowed_result(self):
+        limiter = self._limiter()
+        result = limiter._parse_result(0, [0, 3, 2], now_ms=123_456)
+
+        assert result.allowed is True
+        assert result.remaining == 3
+        assert result.usage == 2
+        assert result.retry_after == 0.0
+
+    def test_parse_denied_result(self):
+        limiter = self._limiter()
+        result = limiter._parse_result(-1, [-1, 7, 5], now_ms=123_456)
+
+        assert result.allowed is False
+        assert result.remaining == 0
+        assert result.retry_after == 7.0
+        assert result.usage == 5